@@ -12,6 +12,8 @@
 #ifndef _SIMPLE_GFX_H
 #define _SIMPLE_GFX_H
 #include <stdint.h>
+#include <stddef.h>
+#include <gfx_config.h>
 
 
 #define GFX_DISPLAY_INVERT_X	8
@@ -50,52 +52,260 @@ typedef struct {
 } GFX_FONT_GLYPHS;
 
 /*
- * state of rotation of the display
+ * Numbers with a fraction (the rotation matrices and the viewport
+ * scaling). Normally these are floats. Parts without an FPU can
+ * build everything with GFX_NO_FLOAT and they are 16.16 fixed point
+ * instead, so there is no floating point per pixel.
  *
+ * Numbers passed to the viewport functions have to go through
+ * GFX_REAL_INT (whole numbers) or GFX_REAL_CONST (constants with a
+ * fraction, folded at compile time). A bare 0.25 quietly becomes 0
+ * in a GFX_NO_FLOAT build, -Wfloat-conversion will find them.
+ */
+#ifdef GFX_NO_FLOAT
+typedef int32_t GFX_REAL;
+#define GFX_REAL_ONE		65536
+#define GFX_REAL_INT(i)		((GFX_REAL) (i) * 65536)
+#define GFX_REAL_CONST(f)	((GFX_REAL) ((f) * 65536))
+#define GFX_REAL_TO_INT(r)	((int) ((r) / 65536))
+#else
+typedef float GFX_REAL;
+#define GFX_REAL_ONE		1.0f
+#define GFX_REAL_INT(i)		((GFX_REAL) (i))
+#define GFX_REAL_CONST(f)	((GFX_REAL) (f))
+#define GFX_REAL_TO_INT(r)	((int) (r))
+#endif
+
+/*
+ * Transform from user space to the display. This is a 2 x 3 affine
+ * matrix, rows 0 and 1 rotate, scale and shear and row 2 moves. It is
+ * applied about the rotation origin (so a plain gfx_rotate() spins
+ * the picture around it) which is why row 2 isn't the same as the
+ * amount everything moves. 'plain' is set when it does nothing at
+ * all, the library can then skip it.
  */
 typedef struct {
-	float	angle;		/* rotation angle */
-	int		x, y;		/* origin of the rotation */
-	float	xfrm[2][2];	/* 2 X 2 matrix */
-} GFX_ROTATION_STATE;
+	GFX_REAL	angle;		/* rotation angle (text only) */
+	int			x, y;		/* origin of the rotation */
+	GFX_REAL	xfrm[3][2];	/* 2 X 3 matrix */
+	uint8_t		plain;		/* identity, user space is display space */
+} GFX_TRANSFORM;
+
+/* how many times gfx_push_state() can be called without a pop */
+#ifndef GFX_STATE_DEPTH
+#define GFX_STATE_DEPTH	4
+#endif
+
+/*
+ * What gfx_push_state() saves, the transforms, the clip rectangle
+ * and the text colors.
+ */
+typedef struct {
+	GFX_TRANSFORM	cr, text_cr;
+	int16_t			clip[4];
+	uint16_t		clipped;
+	GFX_COLOR		fg, bg;
+} GFX_STATE;
 
 /*
  * This maintains the 'state' of the graphics context
  */
 typedef struct {
 	void (*drawpixel)(void *, int, int, GFX_COLOR);	/* user supplied pixel writer */
+	void (*drawspan)(void *, int, int, int, GFX_COLOR);	/* optional run writer */
+	void (*drawcolumn)(void *, int, int, int, GFX_COLOR);	/* optional column writer */
+	void (*copyrect)(void *, int, int, int, int, int, int);	/* optional block mover */
+	void (*drawblend)(void *, int, int, GFX_COLOR, int);	/* optional pixel mixer */
 	uint16_t	w, h;				/* dimensions of drawable space */
 	int16_t cx, cy;					/* current x and y in *user* space */
 	uint16_t	flags;				/* State flags for library */
-	GFX_ROTATION_STATE	cr;
+	uint8_t		cap, join;			/* thick line ends and corners */
+	GFX_TRANSFORM	cr;
 	void *fb;						/* user supplied frame buffer pointer */
 	struct {
 		int16_t cx, cy;				/* Current "cursor" X/Y location */
 		GFX_COLOR bg, fg;			/* Background and foreground colors */
 		GFX_FONT font;				/* Text "font" */
 		int magnify;				/* Text "magnification" */
-		GFX_ROTATION_STATE cr;		/* Text rotation direction */
+		GFX_TRANSFORM cr;			/* Text rotation direction */
 	} text;
 	GFX_FONT_GLYPHS *glyphs;		/* Current font in use */
+	uint32_t	*lazy;				/* tiles waiting to be cleared */
+	GFX_COLOR	lazy_color;			/* color they will be cleared to */
+	struct {
+		int16_t x0, y0, x1, y1;		/* drawable part of the display (x1, y1 excluded) */
+	} clip;
+	GFX_STATE	stack[GFX_STATE_DEPTH];	/* saved by gfx_push_state() */
+	int			depth;
 } GFX_CTX;
 
+/*
+ * A plain in-memory frame buffer, one GFX_COLOR per pixel. When a
+ * context is set up with gfx_init_bitmap() the library knows what
+ * the frame buffer looks like and can use faster paths than calling
+ * the pixel function for every pixel.
+ */
 typedef struct {
+	GFX_COLOR	*pixels;			/* pixel [0, 0] */
+	int			stride;				/* pixels from one row to the next */
+} GFX_BITMAP;
+
+/*
+ * Lazy clear works on square tiles of the bitmap, the tile
+ * state is one bit per tile.
+ */
+#define GFX_TILE_SHIFT	4
+#define GFX_TILE_SIZE	(1 << GFX_TILE_SHIFT)
+#define GFX_LAZY_WORDS(w, h)	\
+	(((((w) + GFX_TILE_SIZE - 1) >> GFX_TILE_SHIFT) * \
+	  (((h) + GFX_TILE_SIZE - 1) >> GFX_TILE_SHIFT) + 31) / 32)
+
+typedef struct __gfx_view {
 	GFX_CTX		*g;
-	float		sx, sy;		/* X scale and Y scale */
-	float		min_x, min_y,
+	GFX_REAL	sx, sy;		/* X scale and Y scale */
+	GFX_REAL	min_x, min_y,
 				max_x, max_y;
 	int			x, y, w, h;	/* box on the screen to use */
+	GFX_REAL	ax, ay;		/* min_x, min_y when it was last scaled */
+	int			ox, oy;		/* pixels panned since then */
+	uint32_t	flags;
+	uint32_t	gen;		/* bumped every time the scaling changes */
+	/* redraws part of the view after a pan or zoom, clip is already set */
+	void		(*redraw)(struct __gfx_view *, int, int, int, int, void *);
+	void		*redraw_arg;
 } GFX_VIEW;
 
+/* viewport flags */
+#define VP_DECIMATE		0x1		/* min/max per column series plotting */
+
+/*
+ * A series being plotted a piece at a time, carries the last
+ * point from one piece to the next.
+ */
+typedef struct {
+	GFX_VIEW	*vp;
+	GFX_COLOR	color;
+	float		lx, ly;		/* last point, in display space */
+	int			lcode;		/* which side(s) of the viewport it was off */
+	int			lcull;		/* and of the part that is being drawn */
+	int			open;		/* decimator has a column span open */
+	int			cx, lo, hi;	/* and this is it */
+} GFX_SERIES;
+
+/* raw sample types, in the host's byte order */
+typedef enum {
+	GFX_SAMPLE_F32 = 0,
+	GFX_SAMPLE_I16,
+	GFX_SAMPLE_U16,
+	GFX_SAMPLE_I8,
+	GFX_SAMPLE_U8,
+	GFX_SAMPLE_I32
+} GFX_SAMPLE_TYPE;
+
+/*
+ * Describes a block of raw samples. Sample i of the channel we
+ * want is at data + i * stride + channel * sizeof(type), its value
+ * is raw * scale + offset and it is plotted at x0 + i * dx.
+ */
+typedef struct {
+	GFX_SAMPLE_TYPE	type;
+	int			channels;	/* interleaved channels per frame */
+	int			channel;	/* which one to plot */
+	int			stride;		/* bytes per frame, 0 is channels * sizeof(type) */
+	float		scale, offset;
+	double		x0, dx;
+} GFX_SAMPLES;
+
+/*
+ * A strip chart, scrolls left by 'step' pixels per sample with the
+ * newest sample at the right edge of the viewport.
+ */
+typedef struct {
+	GFX_VIEW	*vp;
+	float		*ring;		/* the samples still on the chart */
+	int			size;		/* entries in the ring */
+	int			head;		/* where the next sample goes */
+	int			count;		/* samples in the ring */
+	int			step;		/* pixels from one sample to the next */
+	GFX_COLOR	fg, bg;
+} GFX_STRIP;
+
+/*
+ * Series data decimated into bins along X, each bin keeps the first,
+ * last, smallest and largest sample that landed in it. Plotting the
+ * bins costs the same however many samples went into them.
+ */
+typedef struct {
+	float		first, last, min, max;	/* first is NaN if the bin is empty */
+} GFX_M4_BIN;
+
+typedef struct {
+	double		x0, dx;		/* bin i holds [x0 + i * dx, x0 + (i + 1) * dx) */
+	int			n;			/* number of bins */
+	GFX_M4_BIN	*bins;
+} GFX_M4;
+
+/*
+ * Decorations for a view (axes, grid, ticks and labels). They are
+ * drawn once into their own bitmap and that is copied under the data
+ * each frame, until the view is rescaled.
+ */
+#define VP_DECOR_AXES	0x1
+#define VP_DECOR_GRID	0x2
+#define VP_DECOR_TICKS	0x4
+#define VP_DECOR_LABELS	0x8
+
+typedef struct {
+	GFX_VIEW	*vp;
+	int			x, y, w, h;		/* where the layer goes on the display */
+	GFX_BITMAP	layer;			/* the decorations */
+	uint32_t	what;			/* which of VP_DECOR_xxx to draw */
+	uint32_t	gen;			/* view generation the layer was drawn for */
+	uint32_t	renders;		/* times the layer has been drawn */
+	float		xstep, ystep;	/* tick spacing, 0 picks one */
+	GFX_FONT	font;
+	GFX_COLOR	bg, axis, grid, label;
+} GFX_DECOR;
+
 /* Utility functions */
 GFX_CTX *gfx_init(GFX_CTX *ctx, void (*draw)(void *, int, int, GFX_COLOR),
 				int width, int height, GFX_FONT size, void *fb);
+GFX_CTX *gfx_init_bitmap(GFX_CTX *ctx, GFX_BITMAP *bm, int width, int height,
+				GFX_FONT size);
+void gfx_bitmap_pixel(void *fb, int x, int y, GFX_COLOR color);
+void gfx_set_span_func(GFX_CTX *g, void (*span)(void *, int, int, int, GFX_COLOR));
+void gfx_set_column_func(GFX_CTX *g, void (*column)(void *, int, int, int, GFX_COLOR));
+void gfx_set_copy_func(GFX_CTX *g, void (*copy)(void *, int, int, int, int, int, int));
+void gfx_set_blend_func(GFX_CTX *g, void (*blend)(void *, int, int, GFX_COLOR, int));
+int gfx_copy_rect(GFX_CTX *g, int x, int y, int w, int h, int dx, int dy);
+void gfx_draw_bitmap(GFX_CTX *g, int x, int y, GFX_BITMAP *src, int w, int h);
+int gfx_fade_rect(GFX_CTX *g, int x, int y, int w, int h, int amount, uint32_t flags);
+#define GFX_FADE_SUB	0x1		/* gfx_fade_rect subtracts instead of scaling */
 
 void gfx_fill_screen(GFX_CTX *g, GFX_COLOR color);
+/* lazy clear of bitmap contexts, tiles are cleared on first write */
+int gfx_set_lazy_clear(GFX_CTX *g, uint32_t *tiles);
+void gfx_flush(GFX_CTX *g);
+#ifndef GFX_NO_ROTATION
 /* set rotation [0 degress by default] */
 void gfx_rotate(GFX_CTX *g, float angle);
 /* set rotation axis [w/2, h/2] by default */
 void gfx_set_rotation_origin(GFX_CTX *g, int x, int y);
+/* add to the transform, these move, scale, ... what is drawn after them */
+void gfx_translate(GFX_CTX *g, int dx, int dy);
+void gfx_scale(GFX_CTX *g, float sx, float sy);
+void gfx_rotate_by(GFX_CTX *g, float angle);
+void gfx_shear(GFX_CTX *g, float shx, float shy);
+#else
+#define gfx_rotate(g, angle)				((void) (g), (void) (angle))
+#define gfx_set_rotation_origin(g, x, y)	((void) (g), (void) (x), (void) (y))
+#define gfx_translate(g, dx, dy)			((void) (g), (void) (dx), (void) (dy))
+#define gfx_scale(g, sx, sy)				((void) (g), (void) (sx), (void) (sy))
+#define gfx_rotate_by(g, angle)				((void) (g), (void) (angle))
+#define gfx_shear(g, shx, shy)				((void) (g), (void) (shx), (void) (shy))
+#endif
+int gfx_push_state(GFX_CTX *g);
+int gfx_pop_state(GFX_CTX *g);
 void gfx_set_mirrored(GFX_CTX *g, int f);
 
 void gfx_move(GFX_CTX *g, int x, int y);
@@ -104,6 +314,8 @@ void gfx_move_to(GFX_CTX *g, int x, int y);
 /* Drawing functions */
 void gfx_draw_point(GFX_CTX *g, GFX_COLOR color);
 void gfx_draw_point_at(GFX_CTX *g, int x, int y, GFX_COLOR color);
+void gfx_draw_points(GFX_CTX *g, const int *xy, int n, GFX_COLOR color);
+void gfx_draw_segments(GFX_CTX *g, const int *xy, int n, GFX_COLOR color);
 
 void gfx_draw_line(GFX_CTX *g, int x, int y, GFX_COLOR color);
 void gfx_draw_line_to(GFX_CTX *g, int x, int y, GFX_COLOR color);
@@ -127,6 +339,18 @@ void gfx_draw_circle_at(GFX_CTX *g, int x, int y, int r, GFX_COLOR color);
 
 void gfx_fill_circle(GFX_CTX *g, int r, GFX_COLOR color);
 void gfx_fill_circle_at(GFX_CTX *g, int x, int y, int r, GFX_COLOR color);
+void gfx_draw_line_aa(GFX_CTX *g, int x0, int y0, int x1, int y1, GFX_COLOR color);
+void gfx_draw_circle_aa_at(GFX_CTX *g, int x, int y, int r, GFX_COLOR color);
+void gfx_draw_ellipse(GFX_CTX *g, int rx, int ry, GFX_COLOR color);
+void gfx_draw_ellipse_at(GFX_CTX *g, int x, int y, int rx, int ry, GFX_COLOR color);
+void gfx_fill_ellipse(GFX_CTX *g, int rx, int ry, GFX_COLOR color);
+void gfx_fill_ellipse_at(GFX_CTX *g, int x, int y, int rx, int ry, GFX_COLOR color);
+void gfx_draw_arc_at(GFX_CTX *g, int x, int y, int rx, int ry, float start, float end,
+	GFX_COLOR color);
+void gfx_draw_pie_at(GFX_CTX *g, int x, int y, int rx, int ry, float start, float end,
+	GFX_COLOR color);
+void gfx_fill_pie_at(GFX_CTX *g, int x, int y, int rx, int ry, float start, float end,
+	GFX_COLOR color);
 
 void gfx_draw_triangle(GFX_CTX *g, int ax, int ay, int bx, int by, GFX_COLOR c);
 void gfx_draw_triangle_at(GFX_CTX *g, int x, int y, int ax, int ay, int bx, int by, GFX_COLOR c);
@@ -137,16 +361,44 @@ void gfx_fill_triangle_at(GFX_CTX *g, int x, int y, int ax, int ay, int bx, int
 void gfx_fill_triangle_abs(GFX_CTX *g, int x0, int y0, int x1, int y1,
 										int x2, int y2, GFX_COLOR c);
 
+/* polygons, pts is 'n' x, y pairs */
+#ifndef GFX_POLY_MAX
+#define GFX_POLY_MAX	32			/* most vertices in a concave polygon */
+#endif
+int gfx_fill_polygon(GFX_CTX *g, const int *pts, int n, GFX_COLOR c);
+void gfx_draw_polyline(GFX_CTX *g, const int *pts, int n, GFX_COLOR c);
+
+/* thick lines, how the ends and corners are drawn */
+#define GFX_CAP_BUTT	0			/* stops at the end point */
+#define GFX_CAP_SQUARE	1			/* goes half the width past it */
+#define GFX_CAP_ROUND	2			/* half circle around it */
+#define GFX_JOIN_MITER	0			/* pointed, unless very sharp */
+#define GFX_JOIN_BEVEL	1			/* cut off */
+#define GFX_JOIN_ROUND	2			/* rounded */
+void gfx_set_line_style(GFX_CTX *g, int cap, int join);
+void gfx_draw_line_width(GFX_CTX *g, int x0, int y0, int x1, int y1, int width, GFX_COLOR c);
+void gfx_draw_polyline_width(GFX_CTX *g, const int *pts, int n, int width, GFX_COLOR c);
+void gfx_fill_triangles(GFX_CTX *g, const int *verts, const int *indices,
+						int count, GFX_COLOR c);
+
 
 /*
  * Text handling functions.
  * NB: This is 'simple' graphics so each font has at most 256
  *     glyphs.
  */
+#ifndef GFX_NO_TEXT_ROTATION
 void gfx_set_text_rotation(GFX_CTX *g, float angle);
+#else
+#define gfx_set_text_rotation(g, angle)		((void) (g), (void) (angle))
+#endif
 void gfx_set_text_color(GFX_CTX *g, GFX_COLOR fg, GFX_COLOR bg);
 void gfx_set_text_cursor(GFX_CTX *g, int x, int y);
+#ifndef GFX_NO_MAGNIFY
 void gfx_set_text_size(GFX_CTX *g, int sz);
+#else
+#define gfx_set_text_size(g, sz)			((void) (g), (void) (sz))
+#endif
 int gfx_get_text_height(GFX_CTX *g);
 int gfx_get_text_baseline(GFX_CTX *g);
 int gfx_get_text_width(GFX_CTX *g);
@@ -160,17 +412,222 @@ void gfx_draw_glyph(GFX_CTX *g, uint8_t c, GFX_COLOR fg, GFX_COLOR bg);
 void gfx_set_font_glyphs(GFX_CTX *g, GFX_FONT_GLYPHS *glyph);
 
 #define GFX_OOBREPORT	0x1
+#define GFX_FB_BITMAP	0x10		/* fb is a GFX_BITMAP */
+#define GFX_LAZY_CLEAR	0x20		/* gfx_fill_screen is deferred */
+#define GFX_FILL_NONZERO	0x40	/* polygons use non-zero winding */
+#define GFX_CLIP		0x80		/* drawing is limited to the clip rectangle */
 
 void gfx_set(GFX_CTX *g, uint32_t flag);
 void gfx_clear(GFX_CTX *g, uint32_t flag);
+void gfx_set_clip(GFX_CTX *g, int x, int y, int w, int h);
 
 /*
  * View port stuff
  */
+#ifndef GFX_NO_VIEWPORT
 GFX_VIEW *gfx_viewport(GFX_VIEW *v, GFX_CTX *g, int x, int y, int w, int h,
-	float minimum_x, float minimum_y, float maximum_x, float maximum_y);
-void vp_plot(GFX_VIEW *vp, float x0, float y0, float x1, float y1, GFX_COLOR c);
-void vp_rescale(GFX_VIEW *vp, float min_x, float min_y, float max_x, float max_y);
+	GFX_REAL minimum_x, GFX_REAL minimum_y, GFX_REAL maximum_x, GFX_REAL maximum_y);
+void vp_plot(GFX_VIEW *vp, GFX_REAL x0, GFX_REAL y0, GFX_REAL x1, GFX_REAL y1, GFX_COLOR c);
+void vp_rescale(GFX_VIEW *vp, GFX_REAL min_x, GFX_REAL min_y, GFX_REAL max_x, GFX_REAL max_y);
+int vp_transform(GFX_VIEW *vp, GFX_REAL x, GFX_REAL y, int *px, int *py);
+void vp_set_redraw(GFX_VIEW *vp, void (*redraw)(GFX_VIEW *, int, int, int, int, void *),
+	void *arg);
+void vp_pan(GFX_VIEW *vp, int dx, int dy);
+int vp_fade(GFX_VIEW *vp, int amount, uint32_t flags);
+void vp_set_decimate(GFX_VIEW *vp, int on);
+#endif /* GFX_NO_VIEWPORT */
+
+/* the rest of the plotting works on float data */
+#ifndef GFX_NO_FLOAT
+#ifndef GFX_NO_VIEWPORT
+void vp_plot_series(GFX_VIEW *vp, const float *xs, const float *ys, int n, GFX_COLOR c);
+void vp_plot_series_strided(GFX_VIEW *vp, const float *xs, int xstride,
+	const float *ys, int ystride, int n, GFX_COLOR c);
+void vp_plot_points(GFX_VIEW *vp, const float *xs, const float *ys, int n, GFX_COLOR c);
+void vp_plot_segments(GFX_VIEW *vp, const float *xy, int n, GFX_COLOR c);
+void vp_series_begin(GFX_SERIES *s, GFX_VIEW *vp, GFX_COLOR c);
+void vp_series_add(GFX_SERIES *s, const float *xs, int xstride, const float *ys,
+	int ystride, int n);
+void vp_series_samples(GFX_SERIES *s, const GFX_SAMPLES *d, const void *data,
+	long first, long n);
+void vp_series_end(GFX_SERIES *s);
+void vp_plot_samples(GFX_VIEW *vp, const GFX_SAMPLES *d, const void *data, long n,
+	GFX_COLOR c);
+GFX_STRIP *vp_strip_init(GFX_STRIP *s, GFX_VIEW *vp, int step, float *ring, int n,
+	GFX_COLOR fg, GFX_COLOR bg);
+void vp_strip_add(GFX_STRIP *s, float y);
+void vp_strip_redraw(GFX_STRIP *s);
+void vp_zoom(GFX_VIEW *vp, float factor, float cx, float cy);
+GFX_M4 *vp_m4_init(GFX_M4 *m, GFX_M4_BIN *bins, int n, double x0, double dx);
+void vp_m4_add(GFX_M4 *m, const float *xs, const float *ys, long n);
+void vp_m4_plot(GFX_VIEW *vp, GFX_M4 *m, GFX_COLOR c);
+GFX_DECOR *vp_decor_init(GFX_DECOR *d, GFX_VIEW *vp, int x, int y, int w, int h,
+	GFX_COLOR *pixels, uint32_t what);
+void vp_decor_colors(GFX_DECOR *d, GFX_COLOR bg, GFX_COLOR axis, GFX_COLOR grid,
+	GFX_COLOR label);
+void vp_decor_invalidate(GFX_DECOR *d);
+void vp_decor_draw(GFX_DECOR *d);
+#endif /* GFX_NO_VIEWPORT */
+
+/*
+ * Density plots, points are counted per pixel of the view
+ * and the counts shown through a color lookup table.
+ */
+typedef struct {
+	GFX_VIEW	*vp;
+	uint32_t	*counts;		/* w x h counters, a row at a time */
+	int			w, h;			/* view size in pixels (edges included) */
+	uint32_t	max;			/* largest count */
+	uint64_t	points;			/* points added since the last clear */
+} GFX_DENSITY;
+
+#define VP_DENSITY_LOG	0x1		/* scale the counts logarithmically */
+
+#ifndef GFX_NO_VIEWPORT
+GFX_DENSITY *vp_density_init(GFX_DENSITY *d, GFX_VIEW *vp, uint32_t *counts);
+void vp_density_clear(GFX_DENSITY *d);
+void vp_density_add(GFX_DENSITY *d, const float *xs, const float *ys, long n,
+	int threads);
+void vp_density_draw(GFX_DENSITY *d, const GFX_COLOR *lut, int n, uint32_t flags);
+#endif
+
+GFX_COLOR *gfx_colormap(GFX_COLOR *lut, int n, const GFX_COLOR *stops, int nstops);
+GFX_COLOR *gfx_colormap_heat(GFX_COLOR *lut, int n);
+void gfx_colormap_map(const GFX_COLOR *lut, int n, float lo, float hi,
+	const float *v, int count, GFX_COLOR *out);
+
+/*
+ * Waterfall (spectrogram), the newest spectrum is the top
+ * line of the view and older ones move down.
+ */
+typedef struct {
+	GFX_VIEW		*vp;
+	GFX_BITMAP		row;			/* the line being drawn */
+	const GFX_COLOR	*lut;			/* value to color table */
+	int				n;				/* entries in lut */
+	float			lo, hi;			/* values mapped to each end of lut */
+	uint32_t		flags;
+	int				head;			/* next row to write when sweeping */
+	uint32_t		lines;			/* spectra added */
+} GFX_WATERFALL;
+
+#define VP_WATERFALL_SWEEP	0x1		/* overwrite the oldest line, don't scroll */
+
+#ifndef GFX_NO_VIEWPORT
+GFX_WATERFALL *vp_waterfall_init(GFX_WATERFALL *wf, GFX_VIEW *vp, GFX_COLOR *row,
+	const GFX_COLOR *lut, int n, float lo, float hi, uint32_t flags);
+void vp_waterfall_add(GFX_WATERFALL *wf, const float *bins, int nbins);
+#endif
+#endif /* GFX_NO_FLOAT */
+
+/*
+ * Batch rendering, many small independent images spread
+ * across a pool of threads. Each job gets a context that
+ * is already set up for its target.
+ */
+#define GFX_BATCH_MAX_THREADS	64
+
+typedef struct {
+	void	*fb;						/* target buffer for this image */
+	void	(*draw)(void *, int, int, GFX_COLOR);	/* pixel writer for fb */
+	int		w, h;						/* size of the image */
+	void	(*render)(GFX_CTX *, void *);	/* draws the image */
+	void	*arg;						/* passed along to render */
+} GFX_JOB;
+
+typedef struct {
+	int			jobs;				/* jobs rendered */
+	int			threads;			/* threads that did the work */
+	uint64_t	pixels;				/* sum of w * h over all jobs */
+	uint32_t	usec;				/* wall clock time, 0 with no clock */
+	float		jobs_per_sec;
+	float		mpixels_per_sec;
+} GFX_BATCH_STATS;
+
+int gfx_batch_render(GFX_JOB *jobs, int n, int threads, GFX_FONT font,
+	GFX_BATCH_STATS *stats);
+
+/*
+ * Memory for everything the library allocates, carved from a block
+ * the program owns instead of the heap. See lib/src/arena.c
+ */
+typedef struct {
+	uint8_t		*base;				/* the block */
+	size_t		size;				/* bytes in it */
+	size_t		used;				/* bytes handed out */
+	size_t		last;				/* where the last piece starts */
+	size_t		high_water;			/* most bytes ever handed out */
+	uint32_t	failed;				/* allocations refused */
+} GFX_ARENA;
+
+GFX_ARENA *gfx_arena_init(GFX_ARENA *a, void *mem, size_t size);
+void gfx_arena_reset(GFX_ARENA *a);
+GFX_ARENA *gfx_set_arena(GFX_ARENA *a);
+void *gfx_alloc(size_t n);
+void gfx_free(void *p);
+
+/*
+ * Command queue, many tasks queue up drawing commands
+ * without locking and one render task executes them.
+ */
+typedef enum {
+	GFX_CMD_NOP,
+	GFX_CMD_FILL_SCREEN,
+	GFX_CMD_POINT,			/* x, y */
+	GFX_CMD_LINE,			/* x0, y0, x1, y1 */
+	GFX_CMD_RECT,			/* x, y, w, h */
+	GFX_CMD_FILL_RECT,		/* x, y, w, h */
+	GFX_CMD_CIRCLE,			/* x, y, r */
+	GFX_CMD_FILL_CIRCLE,	/* x, y, r */
+	GFX_CMD_TRIANGLE,		/* x0, y0, x1, y1, x2, y2 */
+	GFX_CMD_FILL_TRIANGLE,	/* x0, y0, x1, y1, x2, y2 */
+	GFX_CMD_TEXT			/* x, y, text */
+} GFX_CMD_OP;
+
+#define GFX_CMD_TEXT_MAX	16
+
+typedef struct {
+	uint32_t	seq;				/* slot sequence (queue internal) */
+	uint8_t		op;					/* a GFX_CMD_OP */
+	uint8_t		len;				/* length of text */
+	GFX_COLOR	fg, bg;				/* color (bg for text only) */
+	int16_t		a[6];				/* co-ordinates, see GFX_CMD_OP */
+	char		text[GFX_CMD_TEXT_MAX];
+} GFX_CMD;
+
+typedef struct {
+	GFX_CMD		*slots;				/* ring of commands */
+	uint32_t	mask;				/* number of slots - 1 */
+	uint32_t	head;				/* next slot to drain */
+	uint32_t	tail;				/* next slot to fill */
+	uint32_t	queued;				/* commands put */
+	uint32_t	drained;			/* commands executed */
+	uint32_t	full;				/* puts rejected, queue was full */
+	uint32_t	high_water;			/* most commands ever waiting */
+} GFX_CMDQ;
+
+typedef struct {
+	uint32_t	size, depth, high_water;
+	uint32_t	queued, drained, full;
+} GFX_CMDQ_STATS;
+
+GFX_CMDQ *gfx_cmdq_init(GFX_CMDQ *q, GFX_CMD *slots, int n);
+int gfx_cmdq_put(GFX_CMDQ *q, const GFX_CMD *cmd);
+int gfx_cmdq_drain(GFX_CMDQ *q, GFX_CTX *g, int max);
+void gfx_cmdq_stats(GFX_CMDQ *q, GFX_CMDQ_STATS *st);
+
+int gfx_cmdq_fill_screen(GFX_CMDQ *q, GFX_COLOR color);
+int gfx_cmdq_point(GFX_CMDQ *q, int x, int y, GFX_COLOR color);
+int gfx_cmdq_line(GFX_CMDQ *q, int x0, int y0, int x1, int y1, GFX_COLOR color);
+int gfx_cmdq_rectangle(GFX_CMDQ *q, int x, int y, int w, int h, GFX_COLOR color);
+int gfx_cmdq_fill_rectangle(GFX_CMDQ *q, int x, int y, int w, int h, GFX_COLOR color);
+int gfx_cmdq_circle(GFX_CMDQ *q, int x, int y, int r, GFX_COLOR color);
+int gfx_cmdq_fill_circle(GFX_CMDQ *q, int x, int y, int r, GFX_COLOR color);
+int gfx_cmdq_triangle(GFX_CMDQ *q, int x0, int y0, int x1, int y1,
+	int x2, int y2, GFX_COLOR color);
+int gfx_cmdq_fill_triangle(GFX_CMDQ *q, int x0, int y0, int x1, int y1,
+	int x2, int y2, GFX_COLOR color);
+int gfx_cmdq_puts(GFX_CMDQ *q, int x, int y, char *s, GFX_COLOR fg, GFX_COLOR bg);
 
 /* syntactic sugar really */
 #define gfx_get_width(g)	g->width
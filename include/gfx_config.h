@@ -0,0 +1,66 @@
+/*
+ * Simple Graphics
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * Build configuration, what goes into the library. Everything is in
+ * by default, uncomment a line here (or pass it with -D to both the
+ * library and the program) to leave that piece out. The calls that
+ * only change state (gfx_rotate(), gfx_set_text_size(), ...) become
+ * empty macros so code written for the full library still builds,
+ * the ones that make something (gfx_viewport(), ...) are gone so
+ * using them is an error rather than a quiet no-op.
+ *
+ * 'make configs' builds everything with each of these on its own,
+ * 'make size' does that and then shows what a few of them save.
+ */
+#ifndef _SIMPLE_GFX_CONFIG_H
+#define _SIMPLE_GFX_CONFIG_H
+
+/* 16.16 fixed point instead of float, for parts without an FPU */
+/* #define GFX_NO_FLOAT */
+
+/* no threads in the batch renderer and density plots */
+/* #define GFX_NO_THREADS */
+
+/*
+ * No display transform, gfx_rotate(), gfx_set_rotation_origin(),
+ * gfx_translate(), gfx_scale(), gfx_rotate_by() and gfx_shear() do
+ * nothing and user space is always display space.
+ */
+/* #define GFX_NO_ROTATION */
+
+/* text is always drawn left to right, gfx_set_text_rotation() does nothing */
+/* #define GFX_NO_TEXT_ROTATION */
+
+/* text is always its natural size, gfx_set_text_size() does nothing */
+/* #define GFX_NO_MAGNIFY */
+
+/* no view ports, and so none of the plotting built on them */
+/* #define GFX_NO_VIEWPORT */
+
+/*
+ * Leave fonts out. Asking for a missing font gets the first one of
+ * small, large and tiny that is there, at least one has to be.
+ */
+/* #define GFX_NO_FONT_TINY */
+/* #define GFX_NO_FONT_SMALL */
+/* #define GFX_NO_FONT_LARGE */
+
+/* GFX_OOBREPORT does nothing, so nothing needs printf() */
+/* #define GFX_NO_OOBREPORT */
+
+/*
+ * Never use the heap, things the library would allocate come from
+ * the arena set with gfx_set_arena() or not at all.
+ */
+/* #define GFX_NO_MALLOC */
+
+/* depth of the gfx_push_state() stack, every context has room for it */
+/* #define GFX_STATE_DEPTH	4 */
+
+#if defined(GFX_NO_FONT_TINY) && defined(GFX_NO_FONT_SMALL) && defined(GFX_NO_FONT_LARGE)
+#error "At least one font has to be built in"
+#endif
+
+#endif /* _SIMPLE_GFX_CONFIG_H */
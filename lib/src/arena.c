@@ -0,0 +1,169 @@
+/*
+ * arena.c -- Allocation from a caller supplied block of memory
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Everything in the library that takes a NULL to mean "allocate it
+ * for me" (contexts, views, lookup tables, queues and so on) gets
+ * its memory from gfx_alloc(). Normally that is malloc, but once an
+ * arena is set with gfx_set_arena() it is carved off the front of
+ * the arena's block instead. That never takes longer one time than
+ * another, never fragments, and when the block is used up it says
+ * so (returns NULL) rather than eating into someone else's memory.
+ *
+ * Each piece is preceded by a small header holding where the piece
+ * before it started, so pieces given back with gfx_free() in the
+ * reverse of the order they were taken (scratch memory, mostly) are
+ * reused. Anything else given back stays used until gfx_arena_reset().
+ * None of this is thread safe, allocate from one thread at a time.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <gfx.h>
+
+/* everything handed out is aligned for the largest basic type */
+typedef union {
+	long long	l;
+	double		d;
+	void		*p;
+} ARENA_ALIGN;
+
+#define ALIGN_UP(n)		(((n) + sizeof(ARENA_ALIGN) - 1) & ~(sizeof(ARENA_ALIGN) - 1))
+#define HEADER			ALIGN_UP(sizeof(size_t))
+#define NO_PIECE		((size_t) -1)
+
+/* the arena allocations come from, NULL for malloc */
+static GFX_ARENA *__arena;
+
+/*
+ * gfx_arena_init( ... )
+ *
+ * Set up an arena in the 'size' bytes at 'mem'. If 'a' is NULL the
+ * arena itself is the first thing carved out of 'mem'. Returns the
+ * arena or NULL if 'mem' is too small to hold it.
+ */
+GFX_ARENA *
+gfx_arena_init(GFX_ARENA *a, void *mem, size_t size)
+{
+	uint8_t		*base = mem;
+	size_t		skip;
+
+	/* line the block up so the first piece is aligned */
+	skip = ALIGN_UP((uintptr_t) base) - (uintptr_t) base;
+	if ((mem == NULL) || (size < skip)) {
+		return NULL;
+	}
+	base += skip;
+	size -= skip;
+	if (a == NULL) {
+		if (size < ALIGN_UP(sizeof(GFX_ARENA))) {
+			return NULL;
+		}
+		a = (GFX_ARENA *) base;
+		base += ALIGN_UP(sizeof(GFX_ARENA));
+		size -= ALIGN_UP(sizeof(GFX_ARENA));
+	}
+	a->base = base;
+	a->size = size;
+	a->failed = 0;
+	a->high_water = 0;
+	gfx_arena_reset(a);
+	return a;
+}
+
+/*
+ * gfx_arena_reset( ... )
+ *
+ * Give back everything taken from the arena, the high water mark
+ * and the count of failures are kept.
+ */
+void
+gfx_arena_reset(GFX_ARENA *a)
+{
+	a->used = 0;
+	a->last = NO_PIECE;
+}
+
+/*
+ * gfx_set_arena( ... )
+ *
+ * Make 'a' the arena the library allocates from, NULL goes back to
+ * malloc (or to failing every allocation when built with
+ * GFX_NO_MALLOC). Returns the arena that was in use.
+ */
+GFX_ARENA *
+gfx_set_arena(GFX_ARENA *a)
+{
+	GFX_ARENA	*was = __arena;
+
+	__arena = a;
+	return was;
+}
+
+/*
+ * gfx_alloc( ... )
+ *
+ * Allocate 'n' bytes, from the arena if there is one. Returns NULL
+ * if there isn't room.
+ */
+void *
+gfx_alloc(size_t n)
+{
+	GFX_ARENA	*a = __arena;
+	size_t		need;
+	uint8_t		*res;
+
+	if (a == NULL) {
+#ifdef GFX_NO_MALLOC
+		return NULL;
+#else
+		return malloc(n);
+#endif
+	}
+	need = HEADER + ALIGN_UP(n);
+	if ((n > a->size) || (need > a->size - a->used)) {
+		a->failed++;
+		return NULL;
+	}
+	res = a->base + a->used;
+	*(size_t *) res = a->last;
+	a->last = a->used;
+	a->used += need;
+	a->high_water = (a->used > a->high_water) ? a->used : a->high_water;
+	return res + HEADER;
+}
+
+/*
+ * gfx_free( ... )
+ *
+ * Give back something from gfx_alloc(). In an arena only the last
+ * piece taken can be reused, anything else waits for a reset.
+ */
+void
+gfx_free(void *p)
+{
+	GFX_ARENA	*a = __arena;
+	uint8_t		*piece = p;
+
+	if (p == NULL) {
+		return;
+	}
+	if ((a != NULL) && (piece >= a->base) && (piece < a->base + a->size)) {
+		if ((a->last != NO_PIECE) && (piece - HEADER == a->base + a->last)) {
+			a->used = a->last;
+			a->last = *(size_t *) (piece - HEADER);
+		}
+		return;
+	}
+#ifndef GFX_NO_MALLOC
+	free(p);
+#endif
+}
@@ -0,0 +1,164 @@
+/*
+ * batch.c -- Batch rendering of many small images
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * When you need thousands of small, unrelated images (labels, badges,
+ * thumbnails) the cost of setting up a graphics context for each one
+ * dominates the cost of drawing it. This code takes a list of jobs
+ * and runs them on a small pool of threads. Each thread initializes
+ * one context up front and then just re-targets a copy of it for each
+ * job, so there is no per-job heap allocation and no per-job trig.
+ *
+ * Build with GFX_NO_THREADS defined (the default for the Cortex-M
+ * build) and the jobs are simply run one after the other on the
+ * calling thread. That is timed the same way, as long as the C
+ * library has a monotonic clock to time it with.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#ifndef GFX_NO_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include <gfx.h>
+
+/* shared state for one call to gfx_batch_render */
+struct __batch {
+	GFX_JOB		*jobs;
+	int			n;
+	int			next;		/* next job to hand out */
+	GFX_FONT	font;
+};
+
+/*
+ * Point a copy of the template context at a new target. This is
+ * everything gfx_init() does that depends on the target, the rest
+ * (font, text colors, identity rotation) is already in the template.
+ */
+static void
+__batch_retarget(GFX_CTX *g, GFX_CTX *tmpl, GFX_JOB *job)
+{
+	*g = *tmpl;
+	g->w = job->w;
+	g->h = job->h;
+	g->cr.x = job->w / 2;
+	g->cr.y = job->h / 2;
+	g->fb = job->fb;
+	g->drawpixel = job->draw;
+}
+
+/* microseconds on the monotonic clock, always 0 without one */
+static uint64_t
+__batch_usec(void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec	t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t) t.tv_sec * 1000000 + (uint64_t) t.tv_nsec / 1000;
+#else
+	return 0;
+#endif
+}
+
+/*
+ * Pull jobs off the list until it is empty. Each worker has one
+ * context that lives on its stack for the whole batch.
+ */
+static void *
+__batch_worker(void *arg)
+{
+	struct __batch *b = arg;
+	GFX_CTX	tmpl, ctx;
+	int		i;
+
+	gfx_init(&tmpl, NULL, 0, 0, b->font, NULL);
+	while ((i = __sync_fetch_and_add(&b->next, 1)) < b->n) {
+		__batch_retarget(&ctx, &tmpl, &b->jobs[i]);
+		(b->jobs[i].render)(&ctx, b->jobs[i].arg);
+	}
+	return NULL;
+}
+
+/*
+ * gfx_batch_render( ... )
+ *
+ * Render 'n' jobs using up to 'threads' threads (the calling thread
+ * counts as one). If threads is <= 0 one thread per online CPU is
+ * used. If stats is not NULL it is filled in with the throughput of
+ * the batch. Returns the number of jobs rendered.
+ */
+int
+gfx_batch_render(GFX_JOB *jobs, int n, int threads, GFX_FONT font,
+	GFX_BATCH_STATS *stats)
+{
+	struct __batch	b;
+	uint64_t		pixels = 0;
+	uint64_t		t0;
+	uint32_t		usec;
+	int				i, started = 0;
+#ifndef GFX_NO_THREADS
+	pthread_t		tid[GFX_BATCH_MAX_THREADS];
+#endif
+
+	if ((jobs == NULL) || (n <= 0)) {
+		return 0;
+	}
+	b.jobs = jobs;
+	b.n = n;
+	b.next = 0;
+	b.font = font;
+	for (i = 0; i < n; i++) {
+		pixels += (uint64_t) jobs[i].w * jobs[i].h;
+	}
+
+	t0 = __batch_usec();
+#ifndef GFX_NO_THREADS
+	if (threads <= 0) {
+		threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if (threads > n) {
+		threads = n;
+	}
+	if (threads > GFX_BATCH_MAX_THREADS) {
+		threads = GFX_BATCH_MAX_THREADS;
+	}
+	/* if a thread won't start we just carry on with fewer */
+	for (i = 1; i < threads; i++) {
+		if (pthread_create(&tid[started], NULL, __batch_worker, &b) == 0) {
+			started++;
+		}
+	}
+	__batch_worker(&b);
+	for (i = 0; i < started; i++) {
+		pthread_join(tid[i], NULL);
+	}
+#else
+	(void) threads;
+	__batch_worker(&b);
+#endif
+	usec = (uint32_t) (__batch_usec() - t0);
+
+	if (stats != NULL) {
+		memset(stats, 0, sizeof(GFX_BATCH_STATS));
+		stats->jobs = n;
+		stats->threads = started + 1;
+		stats->pixels = pixels;
+		stats->usec = usec;
+		if (usec > 0) {
+			stats->jobs_per_sec = (float) n * 1000000.0f / usec;
+			stats->mpixels_per_sec = (float) pixels / usec;
+		}
+	}
+	return n;
+}
@@ -0,0 +1,326 @@
+/*
+ * cmdq.c -- Multi-producer draw command queue
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * A GFX_CTX is not safe to share between tasks, it carries cursors
+ * and colors that each call changes. Rather than putting a mutex
+ * around every drawing call, tasks that want to draw encode their
+ * drawing as small fixed size commands and drop them into this ring.
+ * One render task drains the ring into the context.
+ *
+ * The ring is the bounded queue by Dmitry Vyukov. Every slot has a
+ * sequence number that tells a producer whether the slot is free
+ * and tells the consumer whether it has been filled in. Producers
+ * claim a slot with a single compare and swap on the tail and never
+ * wait on each other or on the consumer. If the ring is full the
+ * put fails and is counted, that is the backpressure signal and it
+ * is up to the producer to drop, retry, or coalesce.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <gfx.h>
+
+#define LOAD(p)			__atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE(p, v)		__atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define CAS(p, e, v)	__atomic_compare_exchange_n((p), (e), (v), 0, \
+							__ATOMIC_ACQ_REL, __ATOMIC_RELAXED)
+
+/* commands carry int16_t co-ordinates, rather than wrap they are refused */
+#define FITS16(v)		(((v) >= INT16_MIN) && ((v) <= INT16_MAX))
+
+/*
+ * gfx_cmdq_init( ... )
+ *
+ * Set up a command queue of 'n' slots, n is rounded down to a power
+ * of two. If q or slots are NULL they are allocated.
+ */
+GFX_CMDQ *
+gfx_cmdq_init(GFX_CMDQ *q, GFX_CMD *slots, int n)
+{
+	GFX_CMDQ *res;
+	uint32_t size, i;
+
+	if (n < 2) {
+		return NULL;
+	}
+	for (size = 1; (size << 1) <= (uint32_t) n; size <<= 1) ;
+	res = (q == NULL) ? gfx_alloc(sizeof(GFX_CMDQ)) : q;
+	if (res == NULL) {
+		return NULL;
+	}
+	memset(res, 0, sizeof(GFX_CMDQ));
+	res->slots = (slots == NULL) ? gfx_alloc(size * sizeof(GFX_CMD)) : slots;
+	if (res->slots == NULL) {
+		if (q == NULL) {
+			gfx_free(res);
+		}
+		return NULL;
+	}
+	res->mask = size - 1;
+	for (i = 0; i < size; i++) {
+		res->slots[i].seq = i;
+	}
+	return res;
+}
+
+/*
+ * gfx_cmdq_put( ... )
+ *
+ * Copy a command into the queue. Safe to call from any number of
+ * threads at once. Returns 0 on success, or -1 if the queue is full
+ * (the command is not queued).
+ */
+int
+gfx_cmdq_put(GFX_CMDQ *q, const GFX_CMD *cmd)
+{
+	GFX_CMD		*slot;
+	uint32_t	pos, seq, depth, hw;
+	int32_t		diff;
+
+	pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+	for (;;) {
+		slot = &q->slots[pos & q->mask];
+		seq = LOAD(&slot->seq);
+		diff = (int32_t)(seq - pos);
+		if (diff == 0) {
+			/* slot is free, try to claim it (pos is refreshed on failure) */
+			if (CAS(&q->tail, &pos, pos + 1)) {
+				break;
+			}
+		} else if (diff < 0) {
+			/* consumer hasn't freed this slot yet, we're full */
+			__atomic_fetch_add(&q->full, 1, __ATOMIC_RELAXED);
+			return -1;
+		} else {
+			/* another producer got here first */
+			pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+		}
+	}
+	slot->op = cmd->op;
+	slot->len = cmd->len;
+	slot->fg = cmd->fg;
+	slot->bg = cmd->bg;
+	memcpy(slot->a, cmd->a, sizeof(slot->a));
+	if (cmd->op == GFX_CMD_TEXT) {
+		memcpy(slot->text, cmd->text, sizeof(slot->text));
+	}
+	STORE(&slot->seq, pos + 1);
+
+	__atomic_fetch_add(&q->queued, 1, __ATOMIC_RELAXED);
+	depth = (pos + 1) - LOAD(&q->head);
+	hw = __atomic_load_n(&q->high_water, __ATOMIC_RELAXED);
+	while ((depth > hw) && ! CAS(&q->high_water, &hw, depth)) ;
+	return 0;
+}
+
+/*
+ * Execute one command against the render context.
+ */
+static void
+__cmdq_exec(GFX_CTX *g, GFX_CMD *c)
+{
+	int16_t		*a = c->a;
+	GFX_COLOR	fg, bg;
+
+	switch (c->op) {
+		case GFX_CMD_FILL_SCREEN:
+			gfx_fill_screen(g, c->fg);
+			break;
+		case GFX_CMD_POINT:
+			gfx_draw_point_at(g, a[0], a[1], c->fg);
+			break;
+		case GFX_CMD_LINE:
+			gfx_draw_line_abs(g, a[0], a[1], a[2], a[3], c->fg);
+			break;
+		case GFX_CMD_RECT:
+			gfx_draw_rectangle_at(g, a[0], a[1], a[2], a[3], c->fg);
+			break;
+		case GFX_CMD_FILL_RECT:
+			gfx_fill_rectangle_at(g, a[0], a[1], a[2], a[3], c->fg);
+			break;
+		case GFX_CMD_CIRCLE:
+			gfx_draw_circle_at(g, a[0], a[1], a[2], c->fg);
+			break;
+		case GFX_CMD_FILL_CIRCLE:
+			gfx_fill_circle_at(g, a[0], a[1], a[2], c->fg);
+			break;
+		case GFX_CMD_TRIANGLE:
+			gfx_draw_triangle_abs(g, a[0], a[1], a[2], a[3], a[4], a[5], c->fg);
+			break;
+		case GFX_CMD_FILL_TRIANGLE:
+			gfx_fill_triangle_abs(g, a[0], a[1], a[2], a[3], a[4], a[5], c->fg);
+			break;
+		case GFX_CMD_TEXT:
+			/* the render task's own text colors are put back after */
+			fg = g->text.fg;
+			bg = g->text.bg;
+			c->text[GFX_CMD_TEXT_MAX - 1] = 0;
+			gfx_set_text_color(g, c->fg, c->bg);
+			gfx_set_text_cursor(g, a[0], a[1]);
+			gfx_puts(g, c->text);
+			gfx_set_text_color(g, fg, bg);
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+ * gfx_cmdq_drain( ... )
+ *
+ * Execute up to 'max' queued commands (all of them if max <= 0)
+ * against the context. Only one thread may drain a given queue.
+ * Returns the number of commands executed.
+ */
+int
+gfx_cmdq_drain(GFX_CMDQ *q, GFX_CTX *g, int max)
+{
+	GFX_CMD		*slot;
+	uint32_t	pos;
+	int			n = 0;
+
+	pos = q->head;
+	while ((max <= 0) || (n < max)) {
+		slot = &q->slots[pos & q->mask];
+		if ((int32_t)(LOAD(&slot->seq) - (pos + 1)) < 0) {
+			break;		/* empty, or producer still filling it in */
+		}
+		__cmdq_exec(g, slot);
+		/* hand the slot back to the producers for the next lap */
+		STORE(&slot->seq, pos + q->mask + 1);
+		pos++;
+		STORE(&q->head, pos);
+		n++;
+	}
+	__atomic_fetch_add(&q->drained, n, __ATOMIC_RELAXED);
+	return n;
+}
+
+/*
+ * gfx_cmdq_stats( ... )
+ *
+ * Snapshot the queue statistics.
+ */
+void
+gfx_cmdq_stats(GFX_CMDQ *q, GFX_CMDQ_STATS *st)
+{
+	st->size = q->mask + 1;
+	st->depth = LOAD(&q->tail) - LOAD(&q->head);
+	st->high_water = LOAD(&q->high_water);
+	st->queued = LOAD(&q->queued);
+	st->drained = LOAD(&q->drained);
+	st->full = LOAD(&q->full);
+}
+
+/*
+ * The rest of these are just encoders so that callers don't
+ * have to fill in GFX_CMD structures by hand. They return -1
+ * without queueing anything if a co-ordinate doesn't fit in the
+ * command.
+ */
+static int
+__cmdq_put6(GFX_CMDQ *q, uint8_t op, int a0, int a1, int a2, int a3,
+	int a4, int a5, GFX_COLOR color)
+{
+	GFX_CMD	c;
+
+	if (! (FITS16(a0) && FITS16(a1) && FITS16(a2) &&
+		   FITS16(a3) && FITS16(a4) && FITS16(a5))) {
+		return -1;
+	}
+	c.op = op;
+	c.len = 0;
+	c.fg = c.bg = color;
+	c.a[0] = a0; c.a[1] = a1; c.a[2] = a2;
+	c.a[3] = a3; c.a[4] = a4; c.a[5] = a5;
+	return gfx_cmdq_put(q, &c);
+}
+
+int
+gfx_cmdq_fill_screen(GFX_CMDQ *q, GFX_COLOR color)
+{
+	return __cmdq_put6(q, GFX_CMD_FILL_SCREEN, 0, 0, 0, 0, 0, 0, color);
+}
+
+int
+gfx_cmdq_point(GFX_CMDQ *q, int x, int y, GFX_COLOR color)
+{
+	return __cmdq_put6(q, GFX_CMD_POINT, x, y, 0, 0, 0, 0, color);
+}
+
+int
+gfx_cmdq_line(GFX_CMDQ *q, int x0, int y0, int x1, int y1, GFX_COLOR color)
+{
+	return __cmdq_put6(q, GFX_CMD_LINE, x0, y0, x1, y1, 0, 0, color);
+}
+
+int
+gfx_cmdq_rectangle(GFX_CMDQ *q, int x, int y, int w, int h, GFX_COLOR color)
+{
+	return __cmdq_put6(q, GFX_CMD_RECT, x, y, w, h, 0, 0, color);
+}
+
+int
+gfx_cmdq_fill_rectangle(GFX_CMDQ *q, int x, int y, int w, int h, GFX_COLOR color)
+{
+	return __cmdq_put6(q, GFX_CMD_FILL_RECT, x, y, w, h, 0, 0, color);
+}
+
+int
+gfx_cmdq_circle(GFX_CMDQ *q, int x, int y, int r, GFX_COLOR color)
+{
+	return __cmdq_put6(q, GFX_CMD_CIRCLE, x, y, r, 0, 0, 0, color);
+}
+
+int
+gfx_cmdq_fill_circle(GFX_CMDQ *q, int x, int y, int r, GFX_COLOR color)
+{
+	return __cmdq_put6(q, GFX_CMD_FILL_CIRCLE, x, y, r, 0, 0, 0, color);
+}
+
+int
+gfx_cmdq_triangle(GFX_CMDQ *q, int x0, int y0, int x1, int y1,
+	int x2, int y2, GFX_COLOR color)
+{
+	return __cmdq_put6(q, GFX_CMD_TRIANGLE, x0, y0, x1, y1, x2, y2, color);
+}
+
+int
+gfx_cmdq_fill_triangle(GFX_CMDQ *q, int x0, int y0, int x1, int y1,
+	int x2, int y2, GFX_COLOR color)
+{
+	return __cmdq_put6(q, GFX_CMD_FILL_TRIANGLE, x0, y0, x1, y1, x2, y2, color);
+}
+
+/*
+ * gfx_cmdq_puts( ... )
+ *
+ * Queue a string to be drawn with its text cursor at [x, y]. Strings
+ * longer than GFX_CMD_TEXT_MAX - 1 characters are truncated.
+ */
+int
+gfx_cmdq_puts(GFX_CMDQ *q, int x, int y, char *s, GFX_COLOR fg, GFX_COLOR bg)
+{
+	GFX_CMD	c;
+
+	if (! (FITS16(x) && FITS16(y))) {
+		return -1;
+	}
+	memset(&c, 0, sizeof(c));
+	c.op = GFX_CMD_TEXT;
+	c.fg = fg;
+	c.bg = bg;
+	c.a[0] = x;
+	c.a[1] = y;
+	strncpy(c.text, s, GFX_CMD_TEXT_MAX - 1);
+	c.len = strlen(c.text);
+	return gfx_cmdq_put(q, &c);
+}
@@ -0,0 +1,101 @@
+/*
+ * colormap.c -- Color lookup tables
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Displays that show a quantity as a color (density plots, heat
+ * maps, waterfalls) need a value to color mapping for every pixel.
+ * Working out a blend per pixel is far too slow, so the mapping is
+ * computed once into a table and each pixel is then an index into
+ * it.
+ */
+
+#include <stdint.h>
+#include <gfx.h>
+
+/*
+ * gfx_colormap( ... )
+ *
+ * Fill in an 'n' entry lookup table that blends smoothly through
+ * the 'nstops' colors in 'stops', which are spread evenly from the
+ * first entry to the last. If lut is NULL it is allocated. Returns
+ * the table, or NULL if it couldn't be allocated.
+ */
+GFX_COLOR *
+gfx_colormap(GFX_COLOR *lut, int n, const GFX_COLOR *stops, int nstops)
+{
+	GFX_COLOR	*res = (lut == NULL) ? gfx_alloc(n * sizeof(GFX_COLOR)) : lut;
+	GFX_COLOR	a, b;
+	int			i, k, f;
+
+	if ((res == NULL) || (n < 1) || (nstops < 1)) {
+		return res;
+	}
+	for (i = 0; i < n; i++) {
+		if ((nstops == 1) || (n == 1)) {
+			res[i] = stops[0];
+			continue;
+		}
+		/* position along the stops in 8.8 fixed point */
+		f = (i * (nstops - 1) * 256) / (n - 1);
+		k = f >> 8;
+		f &= 0xff;
+		if (k >= nstops - 1) {
+			res[i] = stops[nstops - 1];
+			continue;
+		}
+		a = stops[k];
+		b = stops[k + 1];
+		res[i].c.b = a.c.b + (((int) b.c.b - (int) a.c.b) * f) / 256;
+		res[i].c.g = a.c.g + (((int) b.c.g - (int) a.c.g) * f) / 256;
+		res[i].c.r = a.c.r + (((int) b.c.r - (int) a.c.r) * f) / 256;
+		res[i].c.a = a.c.a + (((int) b.c.a - (int) a.c.a) * f) / 256;
+	}
+	return res;
+}
+
+/*
+ * gfx_colormap_heat( ... )
+ *
+ * The usual "hot" map, black through blue, red and yellow to white.
+ */
+GFX_COLOR *
+gfx_colormap_heat(GFX_COLOR *lut, int n)
+{
+	const GFX_COLOR	stops[] = {
+		GFX_COLOR_BLACK, GFX_COLOR_DKBLUE, GFX_COLOR_RED,
+		GFX_COLOR_YELLOW, GFX_COLOR_WHITE
+	};
+
+	return gfx_colormap(lut, n, stops, sizeof(stops) / sizeof(stops[0]));
+}
+
+/*
+ * gfx_colormap_map( ... )
+ *
+ * Map 'count' values to colors through the 'n' entry table 'lut',
+ * 'lo' maps to lut[0] and 'hi' to lut[n - 1], values past either end
+ * (and NaNs) are clamped.
+ */
+void
+gfx_colormap_map(const GFX_COLOR *lut, int n, float lo, float hi,
+	const float *v, int count, GFX_COLOR *out)
+{
+	const float	scale = (hi > lo) ? (n - 1) / (hi - lo) : 0;
+	float		f;
+	int			i;
+
+	for (i = 0; i < count; i++) {
+		f = (v[i] - lo) * scale + 0.5f;
+		/* a NaN fails the first test and ends up at 0 */
+		f = (f > 0) ? f : 0;
+		f = (f < n - 1) ? f : n - 1;
+		out[i] = lut[(int) f];
+	}
+}
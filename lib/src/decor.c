@@ -0,0 +1,242 @@
+/*
+ * decor.c -- Cached viewport decorations
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Axes, grid lines, tick marks and labels don't change from frame to
+ * frame, only the data does. Drawing them again every frame (the
+ * labels especially, those go through the glyph code a pixel at a
+ * time) costs more than drawing the data. So they are drawn once into
+ * their own bitmap, and every frame that bitmap is copied onto the
+ * display before the data is plotted on top of it.
+ *
+ * The view keeps a generation number that vp_rescale() and vp_pan()
+ * bump, if it no longer matches the one the layer was drawn for the
+ * layer is drawn again.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <gfx.h>
+
+#ifndef GFX_NO_VIEWPORT
+#ifndef GFX_NO_FLOAT
+
+#define TICK_LEN	2		/* pixels */
+#define X_TICK_GAP	40		/* rough pixels between X ticks */
+#define Y_TICK_GAP	20		/* rough pixels between Y ticks */
+
+/*
+ * vp_decor_init( ... )
+ *
+ * Set up decorations for view 'vp'. The layer is the w x h box at
+ * [x, y] on the display, which normally is the viewport plus some
+ * room to the left and below it for the labels. 'pixels' holds w x h
+ * colors, if it is NULL it is allocated. 'what' is the VP_DECOR_xxx
+ * bits of what to draw.
+ */
+GFX_DECOR *
+vp_decor_init(GFX_DECOR *d, GFX_VIEW *vp, int x, int y, int w, int h,
+	GFX_COLOR *pixels, uint32_t what)
+{
+	GFX_DECOR *res = (d == NULL) ? gfx_alloc(sizeof(GFX_DECOR)) : d;
+
+	if (res == NULL) {
+		return NULL;
+	}
+	res->layer.pixels = (pixels == NULL) ? gfx_alloc(w * h * sizeof(GFX_COLOR)) : pixels;
+	if (res->layer.pixels == NULL) {
+		if (d == NULL) {
+			gfx_free(res);
+		}
+		return NULL;
+	}
+	res->layer.stride = w;
+	res->vp = vp;
+	res->x = x;
+	res->y = y;
+	res->w = w;
+	res->h = h;
+	res->what = what;
+	res->renders = 0;
+	res->xstep = res->ystep = 0;
+	res->font = GFX_FONT_SMALL;
+	res->bg = GFX_COLOR_BLACK;
+	res->axis = GFX_COLOR_WHITE;
+	res->grid = GFX_COLOR_DKGREY;
+	res->label = GFX_COLOR_WHITE;
+	vp_decor_invalidate(res);
+	return res;
+}
+
+/*
+ * vp_decor_colors( ... )
+ *
+ * Change the colors of the decorations.
+ */
+void
+vp_decor_colors(GFX_DECOR *d, GFX_COLOR bg, GFX_COLOR axis, GFX_COLOR grid,
+	GFX_COLOR label)
+{
+	d->bg = bg;
+	d->axis = axis;
+	d->grid = grid;
+	d->label = label;
+	vp_decor_invalidate(d);
+}
+
+/*
+ * vp_decor_invalidate( ... )
+ *
+ * Force the layer to be drawn again on the next vp_decor_draw(), for
+ * changes the view doesn't know about (font, tick spacing, ...).
+ */
+void
+vp_decor_invalidate(GFX_DECOR *d)
+{
+	d->gen = d->vp->gen - 1;
+}
+
+/*
+ * Pick a tick spacing of 1, 2, or 5 times a power of ten that puts
+ * about 'n' ticks across 'range'.
+ */
+static float
+nice_step(float range, int n)
+{
+	float	raw, mag, f;
+
+	if (n < 2) {
+		n = 2;
+	}
+	raw = fabsf(range) / n;
+	if (raw == 0) {
+		return 1;
+	}
+	mag = powf(10, floorf(log10f(raw)));
+	f = raw / mag;
+	if (f < 1.5) {
+		return mag;
+	} else if (f < 3) {
+		return 2 * mag;
+	} else if (f < 7) {
+		return 5 * mag;
+	}
+	return 10 * mag;
+}
+
+/* first tick at or above 'lo' */
+static float
+first_tick(float lo, float step)
+{
+	return ceilf(lo / step - 1e-4f) * step;
+}
+
+/* print a tick value, without the -0 that rounding leaves behind */
+static void
+tick_label(char *buf, int len, float t, float step)
+{
+	if (fabsf(t) < step * 1e-4f) {
+		t = 0;
+	}
+	snprintf(buf, len, "%g", t);
+}
+
+/*
+ * Draw the whole layer. The view is copied and moved so that it is
+ * in layer co-ordinates, then everything is drawn with the usual
+ * calls into a context on the layer bitmap.
+ */
+static void
+decor_render(GFX_DECOR *d)
+{
+	GFX_CTX		g;
+	GFX_VIEW	v = *d->vp;
+	float		xstep, ystep, x0, y0, ax, ay, t;
+	int			i, px, py, axis_x, axis_y, th, bl;
+	char		buf[16];
+
+	gfx_init_bitmap(&g, &d->layer, d->w, d->h, d->font);
+	v.g = &g;
+	v.x -= d->x;
+	v.y -= d->y;
+	gfx_fill_screen(&g, d->bg);
+
+	xstep = (d->xstep > 0) ? d->xstep : nice_step(v.max_x - v.min_x, v.w / X_TICK_GAP);
+	ystep = (d->ystep > 0) ? d->ystep : nice_step(v.max_y - v.min_y, v.h / Y_TICK_GAP);
+	x0 = first_tick(v.min_x, xstep);
+	y0 = first_tick(v.min_y, ystep);
+	/* axes go through 0 if it is on the view, else along the minimum */
+	ax = ((v.min_x <= 0) && (v.max_x >= 0)) ? 0 : v.min_x;
+	ay = ((v.min_y <= 0) && (v.max_y >= 0)) ? 0 : v.min_y;
+	vp_transform(&v, ax, ay, &axis_x, &axis_y);
+
+	if (d->what & VP_DECOR_GRID) {
+		for (i = 0; (t = x0 + i * xstep) <= v.max_x; i++) {
+			vp_plot(&v, t, v.min_y, t, v.max_y, d->grid);
+		}
+		for (i = 0; (t = y0 + i * ystep) <= v.max_y; i++) {
+			vp_plot(&v, v.min_x, t, v.max_x, t, d->grid);
+		}
+	}
+	if (d->what & VP_DECOR_AXES) {
+		vp_plot(&v, v.min_x, ay, v.max_x, ay, d->axis);
+		vp_plot(&v, ax, v.min_y, ax, v.max_y, d->axis);
+	}
+
+	th = gfx_get_text_height(&g);
+	bl = gfx_get_text_baseline(&g);
+	gfx_set_text_color(&g, d->label, d->label);
+	for (i = 0; (t = x0 + i * xstep) <= v.max_x; i++) {
+		vp_transform(&v, t, ay, &px, &py);
+		if (d->what & VP_DECOR_TICKS) {
+			gfx_draw_line_abs(&g, px, axis_y + 1, px, axis_y + TICK_LEN, d->axis);
+		}
+		if (d->what & VP_DECOR_LABELS) {
+			tick_label(buf, sizeof(buf), t, xstep);
+			gfx_set_text_cursor(&g, px - gfx_get_string_width(&g, buf) / 2,
+				axis_y + TICK_LEN + 1 + bl);
+			gfx_puts(&g, buf);
+		}
+	}
+	for (i = 0; (t = y0 + i * ystep) <= v.max_y; i++) {
+		vp_transform(&v, ax, t, &px, &py);
+		if (d->what & VP_DECOR_TICKS) {
+			gfx_draw_line_abs(&g, axis_x - TICK_LEN, py, axis_x - 1, py, d->axis);
+		}
+		if (d->what & VP_DECOR_LABELS) {
+			tick_label(buf, sizeof(buf), t, ystep);
+			gfx_set_text_cursor(&g, axis_x - TICK_LEN - 1 - gfx_get_string_width(&g, buf),
+				py - th / 2 + bl);
+			gfx_puts(&g, buf);
+		}
+	}
+	d->gen = d->vp->gen;
+	d->renders++;
+}
+
+/*
+ * vp_decor_draw( ... )
+ *
+ * Put the decorations on the display, drawing the layer first if
+ * the view has been rescaled or panned since it was last drawn. Call
+ * it before plotting the data so the data ends up on top.
+ */
+void
+vp_decor_draw(GFX_DECOR *d)
+{
+	if (d->gen != d->vp->gen) {
+		decor_render(d);
+	}
+	gfx_draw_bitmap(d->vp->g, d->x, d->y, &d->layer, d->w, d->h);
+}
+#endif /* GFX_NO_FLOAT */
+#endif /* GFX_NO_VIEWPORT */
@@ -0,0 +1,260 @@
+/*
+ * density.c -- Density (heat map) plots
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * When millions of points land in a view most of them land on pixels
+ * that are already set, so a scatter plot in one color shows where
+ * there is data but not how much. Here instead each pixel of the view
+ * has a counter, points just bump the counter of the pixel they land
+ * on, and when it is time to show it one pass turns the counts into
+ * colors through a lookup table (see colormap.c). Eye diagrams and
+ * other signal integrity displays come out as the familiar heat map.
+ *
+ * Binning is a transform, a bounds test and an increment per point,
+ * so it goes about as fast as the points can be read. Big batches
+ * can be split across threads, each thread counts into its own
+ * buffer (so there is no sharing of cache lines) and the buffers are
+ * added together at the end. Build with GFX_NO_THREADS and it is all
+ * done on the calling thread.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifndef GFX_NO_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include <gfx.h>
+
+#ifndef GFX_NO_VIEWPORT
+#ifndef GFX_NO_FLOAT
+
+/* pixels colored per call to gfx_draw_bitmap */
+#define DENSITY_ROW	128
+
+/* don't bother starting a thread for less than this many points */
+#define DENSITY_MIN_POINTS	65536
+
+/*
+ * vp_density_init( ... )
+ *
+ * Set up a density plot covering viewport 'vp'. 'counts' must have
+ * room for (w + 1) * (h + 1) counters (the view covers its edges), if
+ * it is NULL it is allocated. Returns NULL if it couldn't be.
+ */
+GFX_DENSITY *
+vp_density_init(GFX_DENSITY *d, GFX_VIEW *vp, uint32_t *counts)
+{
+	GFX_DENSITY *res = (d == NULL) ? gfx_alloc(sizeof(GFX_DENSITY)) : d;
+
+	if (res == NULL) {
+		return NULL;
+	}
+	res->vp = vp;
+	res->w = vp->w + 1;
+	res->h = vp->h + 1;
+	res->counts = (counts == NULL) ?
+		gfx_alloc(res->w * res->h * sizeof(uint32_t)) : counts;
+	if (res->counts == NULL) {
+		if (d == NULL) {
+			gfx_free(res);
+		}
+		return NULL;
+	}
+	vp_density_clear(res);
+	return res;
+}
+
+/*
+ * vp_density_clear( ... )
+ *
+ * Zero all of the counts.
+ */
+void
+vp_density_clear(GFX_DENSITY *d)
+{
+	memset(d->counts, 0, d->w * d->h * sizeof(uint32_t));
+	d->max = 0;
+	d->points = 0;
+}
+
+/* one slice of the points and where to count them */
+struct __bin_job {
+	GFX_DENSITY	*d;
+	const float	*xs, *ys;
+	long		n;
+	uint32_t	*counts;
+	uint32_t	max;
+};
+
+/*
+ * Count a run of points. This is the same arithmetic as the viewport
+ * transform so a point is counted on the pixel vp_plot_points() would
+ * draw it on. Points off the view (and NaNs, which fail every compare)
+ * are dropped.
+ */
+static void *
+__bin(void *arg)
+{
+	struct __bin_job	*j = arg;
+	GFX_VIEW			*v = j->d->vp;
+	uint32_t			*counts = j->counts, max = j->max, c;
+	const float			x0 = v->x, x1 = v->x + v->w;
+	const float			y0 = v->y, y1 = v->y + v->h;
+	const float			xa = v->x + v->ox, yb = v->h + v->y + v->oy;
+	const int			w = j->d->w;
+	float				fx, fy;
+	long				i;
+
+	for (i = 0; i < j->n; i++) {
+		fx = (j->xs[i] - v->ax) * v->sx + xa;
+		fy = yb - ((j->ys[i] - v->ay) * v->sy);
+		if ((fx >= x0) && (fx <= x1) && (fy >= y0) && (fy <= y1)) {
+			c = ++counts[((int) fy - v->y) * w + ((int) fx - v->x)];
+			max = (c > max) ? c : max;
+		}
+	}
+	j->max = max;
+	return NULL;
+}
+
+/*
+ * vp_density_add( ... )
+ *
+ * Count 'n' points. If threads is more than 1 (or <= 0 for one per
+ * online CPU) and there are enough points, the points are split
+ * between that many threads (the calling thread is one of them). The
+ * extra threads need a buffer of counts each, if those can't be
+ * allocated fewer threads are used.
+ */
+void
+vp_density_add(GFX_DENSITY *d, const float *xs, const float *ys, long n,
+	int threads)
+{
+	struct __bin_job	job[GFX_BATCH_MAX_THREADS];
+	long				per, i;
+	int					t, used = 1;
+#ifndef GFX_NO_THREADS
+	pthread_t			tid[GFX_BATCH_MAX_THREADS];
+	int					running[GFX_BATCH_MAX_THREADS];
+	size_t				size = d->w * d->h * sizeof(uint32_t);
+#endif
+
+	if (n <= 0) {
+		return;
+	}
+#ifndef GFX_NO_THREADS
+	if (threads <= 0) {
+		threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if (threads > n / DENSITY_MIN_POINTS) {
+		threads = n / DENSITY_MIN_POINTS;
+	}
+	if (threads > GFX_BATCH_MAX_THREADS) {
+		threads = GFX_BATCH_MAX_THREADS;
+	}
+	/* every thread but the first needs counts of its own */
+	for (used = 1; used < threads; used++) {
+		if ((job[used].counts = gfx_alloc(size)) == NULL) {
+			break;
+		}
+		memset(job[used].counts, 0, size);
+		job[used].max = 0;
+	}
+#else
+	(void) threads;
+#endif
+	job[0].counts = d->counts;
+	job[0].max = d->max;
+	per = (n + used - 1) / used;
+	for (t = 0; t < used; t++) {
+		job[t].d = d;
+		job[t].xs = xs + t * per;
+		job[t].ys = ys + t * per;
+		job[t].n = (n - t * per < per) ? n - t * per : per;
+	}
+
+#ifndef GFX_NO_THREADS
+	/* a thread that won't start has its slice done here instead */
+	for (t = 1; t < used; t++) {
+		running[t] = (pthread_create(&tid[t], NULL, __bin, &job[t]) == 0);
+	}
+	__bin(&job[0]);
+	for (t = 1; t < used; t++) {
+		if (running[t]) {
+			pthread_join(tid[t], NULL);
+		} else {
+			__bin(&job[t]);
+		}
+	}
+	d->max = job[0].max;
+	/* fold the other buffers into the real one, last taken first given back */
+	for (t = used - 1; t > 0; t--) {
+		for (i = 0; i < d->w * d->h; i++) {
+			d->counts[i] += job[t].counts[i];
+			d->max = (d->counts[i] > d->max) ? d->counts[i] : d->max;
+		}
+		gfx_free(job[t].counts);
+	}
+#else
+	__bin(&job[0]);
+	d->max = job[0].max;
+	(void) i;
+#endif
+	d->points += n;
+}
+
+/*
+ * vp_density_draw( ... )
+ *
+ * Color the view by its counts using the 'n' entry table 'lut'. No
+ * points is lut[0] and the largest count is lut[n - 1]. With
+ * VP_DENSITY_LOG in flags the counts are scaled logarithmically,
+ * which keeps the rarely hit pixels visible next to very busy ones.
+ */
+void
+vp_density_draw(GFX_DENSITY *d, const GFX_COLOR *lut, int n, uint32_t flags)
+{
+	GFX_COLOR	row[DENSITY_ROW];
+	GFX_BITMAP	bm;
+	uint32_t	*c, scale;
+	float		lscale;
+	int			i, x, y, k, len;
+
+	bm.pixels = row;
+	bm.stride = DENSITY_ROW;
+	/*
+	 * 16.16 fixed point so the linear case has no divide per pixel,
+	 * both round up so that any count at all shows as lut[1] or more
+	 */
+	scale = (d->max > 0) ? (uint32_t) (((uint64_t) (n - 1) << 16) / d->max) : 0;
+	lscale = (d->max > 0) ? (n - 2) / logf(1.0f + d->max) : 0;
+	for (y = 0; y < d->h; y++) {
+		c = d->counts + y * d->w;
+		for (x = 0; x < d->w; x += DENSITY_ROW) {
+			len = (d->w - x < DENSITY_ROW) ? d->w - x : DENSITY_ROW;
+			if (flags & VP_DENSITY_LOG) {
+				for (k = 0; k < len; k++) {
+					i = (c[x + k] == 0) ? 0 : 1 + (int) (logf(1.0f + c[x + k]) * lscale);
+					row[k] = lut[(i < n) ? i : n - 1];
+				}
+			} else {
+				for (k = 0; k < len; k++) {
+					row[k] = lut[((uint64_t) c[x + k] * scale + 0xffff) >> 16];
+				}
+			}
+			gfx_draw_bitmap(d->vp->g, d->vp->x + x, d->vp->y + y, &bm, len, 1);
+		}
+	}
+}
+#endif /* GFX_NO_FLOAT */
+#endif /* GFX_NO_VIEWPORT */
@@ -22,6 +22,7 @@
 #include <stdint.h>
 #include "gfx.h"
 
+#ifndef GFX_NO_FONT_SMALL
 /*
  * This is a small 5 x 7 font you commonly find
  * in character drive LCD displays. Character 'box'
@@ -298,7 +299,9 @@ GFX_FONT_GLYPHS small_font = {
 	0,
 	6, 8, 7
 };
+#endif
 
+#ifndef GFX_NO_FONT_LARGE
 /*
  *  Ascii 7 x 12 font
  * 
@@ -464,7 +467,9 @@ GFX_FONT_GLYPHS large_font = {
 	1,
 	8, 12, 9
 };
+#endif
 
+#ifndef GFX_NO_FONT_TINY
 /*
  * A very tiny font in a 4x6 box, this was inspired by
  * the 'Tom Thumb' font on Robey's site, although it has
@@ -610,3 +615,4 @@ GFX_FONT_GLYPHS tiny_font = {
 	0,
 	4, 6, 5
 };
+#endif
@@ -12,17 +12,40 @@
  *
  */
 
-#include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <gfx.h>
+#ifndef GFX_NO_OOBREPORT
+#include <stdio.h>
+#endif
 
 #define DEBUG
+#ifndef GFX_NO_FONT_SMALL
 extern GFX_FONT_GLYPHS small_font;
+#endif
+#ifndef GFX_NO_FONT_LARGE
 extern GFX_FONT_GLYPHS large_font;
+#endif
+#ifndef GFX_NO_FONT_TINY
 extern GFX_FONT_GLYPHS tiny_font;
+#endif
+
+/*
+ * The pieces gfx_config.h can leave out. These are constants when
+ * they are out so the code that would use them drops away.
+ */
+#ifdef GFX_NO_OOBREPORT
+#define OOB_REPORTING(g)	0
+#else
+#define OOB_REPORTING(g)	((g)->flags & GFX_OOBREPORT)
+#endif
+#ifdef GFX_NO_MAGNIFY
+#define MAGNIFY(g)			1
+#else
+#define MAGNIFY(g)			((g)->text.magnify)
+#endif
 
 void
 gfx_set(GFX_CTX *g, uint32_t flag)
@@ -36,21 +59,46 @@ gfx_clear(GFX_CTX *g, uint32_t flag)
 	g->flags = (g->flags & ~(flag));
 }
 
+/*
+ * gfx_set_clip( ... )
+ *
+ * Only let drawing touch the w x h rectangle at [x, y] (display
+ * co-ordinates, after rotation and before mirroring, the same space
+ * the screen edges are checked in). It is trimmed to the screen.
+ * gfx_clear(g, GFX_CLIP) turns clipping off again.
+ */
+void
+gfx_set_clip(GFX_CTX *g, int x, int y, int w, int h)
+{
+	g->clip.x0 = (x < 0) ? 0 : x;
+	g->clip.y0 = (y < 0) ? 0 : y;
+	g->clip.x1 = ((x + w) > g->w) ? g->w : x + w;
+	g->clip.y1 = ((y + h) > g->h) ? g->h : y + h;
+	g->flags |= GFX_CLIP;
+}
+
 /*
  * Must be called first. Sets up the graphics context and
- * sets the display size.
+ * sets the display size. If ctx is NULL it is allocated, returns
+ * NULL if that fails.
  */
 GFX_CTX *
 gfx_init(GFX_CTX *ctx, void (*pixel_func)(void *, int, int, GFX_COLOR), int width, int height, GFX_FONT font, void *fb)
 {
-	GFX_CTX *res = (ctx == NULL) ? malloc(sizeof(GFX_CTX)) : ctx;
+	GFX_CTX *res = (ctx == NULL) ? gfx_alloc(sizeof(GFX_CTX)) : ctx;
 
+	if (res == NULL) {
+		return NULL;
+	}
 	memset((uint8_t *)res, 0, sizeof(GFX_CTX));
 	res->w			= width;
 	res->h			= height;
 	res->cr.x	= width / 2;
 	res->cr.y	= height / 2; 
 	gfx_rotate(res, 0);
+#ifdef GFX_NO_ROTATION
+	res->cr.plain = 1;
+#endif
 	res->cx = res->cy = 0;
 	gfx_set_font(res, font);
 	res->text.font  = font;
@@ -66,6 +114,99 @@ gfx_init(GFX_CTX *ctx, void (*pixel_func)(void *, int, int, GFX_COLOR), int widt
 	return res;
 }
 
+/*
+ * gfx_set_span_func( ... )
+ *
+ * Optionally supply a function that paints a horizontal run of
+ * 'len' pixels starting at [x, y] in display co-ordinates. Filled
+ * shapes use it when the display isn't rotated, so a display that
+ * can do a run in one go (a memset, a DMA fill, a single address
+ * window on an LCD controller) doesn't have to take it a pixel at
+ * a time.
+ */
+void
+gfx_set_span_func(GFX_CTX *g, void (*span_func)(void *, int, int, int, GFX_COLOR))
+{
+	g->drawspan = span_func;
+}
+
+/*
+ * gfx_set_column_func( ... )
+ *
+ * Optionally supply a function that paints a vertical run of 'len'
+ * pixels starting at [x, y] and going down, in display co-ordinates.
+ * Lines are painted a run at a time, shallow ones as spans and
+ * steep ones as columns, so with both functions a line costs a call
+ * per run rather than per pixel.
+ */
+void
+gfx_set_column_func(GFX_CTX *g, void (*column_func)(void *, int, int, int, GFX_COLOR))
+{
+	g->drawcolumn = column_func;
+}
+
+/*
+ * gfx_set_copy_func( ... )
+ *
+ * Optionally supply a function that moves the w x h block of
+ * pixels at [x, y] (display co-ordinates) by [dx, dy]. The blocks
+ * may overlap. It lets gfx_copy_rect() scroll a display that has
+ * its own frame buffer (or a blitter) without redrawing. Plain
+ * GFX_BITMAP frame buffers don't need one.
+ */
+void
+gfx_set_copy_func(GFX_CTX *g, void (*copy_func)(void *, int, int, int, int, int, int))
+{
+	g->copyrect = copy_func;
+}
+
+/*
+ * gfx_set_blend_func( ... )
+ *
+ * Optionally supply a function that mixes 'color' into the pixel at
+ * [x, y] (display co-ordinates), 'alpha' (1 - 255) is how much of
+ * it. The anti-aliased lines and circles use it for their edge
+ * pixels. Without one they blend straight into a GFX_BITMAP, and on
+ * any other display just paint the pixels that are at least half
+ * covered.
+ */
+void
+gfx_set_blend_func(GFX_CTX *g, void (*blend_func)(void *, int, int, GFX_COLOR, int))
+{
+	g->drawblend = blend_func;
+}
+
+/*
+ * gfx_bitmap_pixel( ... )
+ *
+ * The pixel writer for a plain in-memory frame buffer (a GFX_BITMAP).
+ */
+void
+gfx_bitmap_pixel(void *fb, int x, int y, GFX_COLOR color)
+{
+	GFX_BITMAP *bm = fb;
+	bm->pixels[y * bm->stride + x] = color;
+}
+
+/*
+ * gfx_init_bitmap( ... )
+ *
+ * Like gfx_init() but for a plain in-memory frame buffer. Since the
+ * library knows what the pixels look like it can skip the per pixel
+ * callback for things like clearing the screen.
+ */
+GFX_CTX *
+gfx_init_bitmap(GFX_CTX *ctx, GFX_BITMAP *bm, int width, int height, GFX_FONT font)
+{
+	GFX_CTX *res = gfx_init(ctx, gfx_bitmap_pixel, width, height, font, bm);
+
+	if (res == NULL) {
+		return NULL;
+	}
+	res->flags |= GFX_FB_BITMAP;
+	return res;
+}
+
 /*
  * Define some helper routines, the first
  * swaps two ints using the XOR function.
@@ -82,7 +223,174 @@ gfx_init(GFX_CTX *ctx, void (*pixel_func)(void *, int, int, GFX_COLOR), int widt
 
 #define pgm_read_byte(addr) (*(const unsigned char *)(addr))
 
+#ifndef GFX_NO_ROTATION
 #define NOTRANSFORM
+#endif
+
+/*
+ * Arithmetic on GFX_REALs. RDOT (x * a + y * b), RXFORM (the same
+ * plus t) and RMULI (x * a) take ints and give an int truncated
+ * toward zero, like converting the float result does, they are for
+ * the transforms. The rest are for the thick line corners. In 16.16
+ * fixed point products are done in 64 bits, and RHYPOT is the length
+ * of [a, b].
+ */
+#ifdef GFX_NO_FLOAT
+#define RDOT(x, a, y, b)	((int) (((int64_t) (x) * (a) + (int64_t) (y) * (b)) / 65536))
+#define RXFORM(x, a, y, b, t)	\
+	((int) (((int64_t) (x) * (a) + (int64_t) (y) * (b) + (t)) / 65536))
+#define RMULI(x, a)			((int) (((int64_t) (x) * (a)) / 65536))
+#define RMUL(a, b)			((GFX_REAL) (((int64_t) (a) * (b)) / 65536))
+#define RDIV(a, b)			((GFX_REAL) (((int64_t) (a) * 65536) / (b)))
+#define RMULDIV(a, b, c)	((GFX_REAL) (((int64_t) (a) * (b)) / (c)))
+#define RCEIL(a)			((int) (((a) + 65535) >> 16))
+#define RHYPOT(a, b)		((GFX_REAL) __isqrt64((int64_t) (a) * (a) + (int64_t) (b) * (b)))
+#define REAL_BIG			INT32_MAX
+
+/*
+ * Integer square root, rounded down.
+ */
+static uint32_t
+__isqrt64(uint64_t v)
+{
+	uint64_t	r = 0, bit = (uint64_t) 1 << 62;
+
+	while (bit > v) {
+		bit >>= 2;
+	}
+	while (bit != 0) {
+		if (v >= r + bit) {
+			v -= r + bit;
+			r = (r >> 1) + bit;
+		} else {
+			r >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t) r;
+}
+#else
+#define RDOT(x, a, y, b)	((x) * (a) + (y) * (b))
+#define RXFORM(x, a, y, b, t)	((x) * (a) + (y) * (b) + (t))
+#define RMULI(x, a)			((x) * (a))
+#define RMUL(a, b)			((a) * (b))
+#define RDIV(a, b)			((a) / (b))
+#define RMULDIV(a, b, c)	((a) * (b) / (c))
+#define RCEIL(a)			((int) ceilf(a))
+#define RHYPOT(a, b)		sqrtf((a) * (a) + (b) * (b))
+#define REAL_BIG			1e30f
+#endif
+
+/*
+ * Lazy clear support. When it is on, clearing the screen just marks
+ * every tile as 'needs clearing' and the tile is actually filled in
+ * the first time a pixel in it is written (or when gfx_flush() is
+ * called). Only done for GFX_BITMAP frame buffers.
+ */
+#define TILES_X(g)	(((g)->w + GFX_TILE_SIZE - 1) >> GFX_TILE_SHIFT)
+
+static void
+__lazy_fill_tile(GFX_CTX *g, int tx, int ty)
+{
+	GFX_BITMAP	*bm = g->fb;
+	GFX_COLOR	*p;
+	int x, y, x1, y1;
+
+	x1 = (tx + 1) << GFX_TILE_SHIFT;
+	y1 = (ty + 1) << GFX_TILE_SHIFT;
+	x1 = (x1 > g->w) ? g->w : x1;
+	y1 = (y1 > g->h) ? g->h : y1;
+	for (y = ty << GFX_TILE_SHIFT; y < y1; y++) {
+		p = bm->pixels + y * bm->stride;
+		for (x = tx << GFX_TILE_SHIFT; x < x1; x++) {
+			p[x] = g->lazy_color;
+		}
+	}
+}
+
+/*
+ * Called with display co-ordinates of a pixel about to be
+ * written, clears its tile first if that is still pending.
+ */
+static inline void
+__lazy_touch(GFX_CTX *g, int x, int y)
+{
+	int	tx = x >> GFX_TILE_SHIFT;
+	int ty = y >> GFX_TILE_SHIFT;
+	int	t = ty * TILES_X(g) + tx;
+
+	if (g->lazy[t >> 5] & (1u << (t & 31))) {
+		g->lazy[t >> 5] &= ~(1u << (t & 31));
+		__lazy_fill_tile(g, tx, ty);
+	}
+}
+
+/*
+ * Same thing for every tile under a block of pixels.
+ */
+static void
+__lazy_touch_rect(GFX_CTX *g, int x, int y, int w, int h)
+{
+	int	tx, ty;
+
+	for (ty = y >> GFX_TILE_SHIFT; ty <= (y + h - 1) >> GFX_TILE_SHIFT; ty++) {
+		for (tx = x >> GFX_TILE_SHIFT; tx <= (x + w - 1) >> GFX_TILE_SHIFT; tx++) {
+			__lazy_touch(g, tx << GFX_TILE_SHIFT, ty << GFX_TILE_SHIFT);
+		}
+	}
+}
+
+/*
+ * gfx_set_lazy_clear( ... )
+ *
+ * Turn on lazy clearing for a bitmap context. 'tiles' must have
+ * room for GFX_LAZY_WORDS(w, h) words, or be NULL to have it
+ * allocated. Returns 0 on success, -1 if the context isn't
+ * drawing into a GFX_BITMAP.
+ */
+int
+gfx_set_lazy_clear(GFX_CTX *g, uint32_t *tiles)
+{
+	int n = GFX_LAZY_WORDS(g->w, g->h);
+
+	if ((g->flags & GFX_FB_BITMAP) == 0) {
+		return -1;
+	}
+	g->lazy = (tiles == NULL) ? gfx_alloc(n * sizeof(uint32_t)) : tiles;
+	if (g->lazy == NULL) {
+		return -1;
+	}
+	memset(g->lazy, 0, n * sizeof(uint32_t));
+	g->flags |= GFX_LAZY_CLEAR;
+	return 0;
+}
+
+/*
+ * gfx_flush( ... )
+ *
+ * Fill in any tiles that were cleared but never drawn on. Call
+ * this before handing the bitmap to the display.
+ */
+void
+gfx_flush(GFX_CTX *g)
+{
+	int t, n;
+
+	if ((g->flags & GFX_LAZY_CLEAR) == 0) {
+		return;
+	}
+	n = TILES_X(g) * ((g->h + GFX_TILE_SIZE - 1) >> GFX_TILE_SHIFT);
+	for (t = 0; t < n; t++) {
+		if (g->lazy[t >> 5] == 0) {
+			t |= 31;	/* whole word is done, skip it */
+			continue;
+		}
+		if (g->lazy[t >> 5] & (1u << (t & 31))) {
+			g->lazy[t >> 5] &= ~(1u << (t & 31));
+			__lazy_fill_tile(g, t % TILES_X(g), t / TILES_X(g));
+		}
+	}
+}
 
 /*
  * Architectural note: the __paint_xxx functions
@@ -103,36 +411,51 @@ gfx_init(GFX_CTX *ctx, void (*pixel_func)(void *, int, int, GFX_COLOR), int widt
  * is easy because there is FP hardware on the M4F series.
  * but it could be abstracted out perhaps.
  */
-static void
-__paint_pixel(GFX_CTX *gfx, int x, int y, GFX_COLOR color)
+static inline int
+__display_xy(GFX_CTX *gfx, int *px, int *py)
 {
+	int x = *px, y = *py;
+#ifdef NOTRANSFORM
 	int xt, yt; 	/* transformed versions */
+#endif
+#ifndef GFX_NO_OOBREPORT
 	int save[2];
 	save[0] = x;
 	save[1] = y;
+#endif
 	/*
 	 * Transform the co-ordinates from user space
 	 * into display space.
 	 */
 #ifdef NOTRANSFORM
-	/* translate to the rotation center */
-	x -= gfx->cr.x;
-	y -= gfx->cr.y;
-	/* rotate */
-	xt = x * gfx->cr.xfrm[0][0] + y * gfx->cr.xfrm[1][0];
-	yt = x * gfx->cr.xfrm[0][1] + y * gfx->cr.xfrm[1][1];
-	/* translate back in the real world */
-	x = xt + gfx->cr.x;
-	y = yt + gfx->cr.y;
+	if (! gfx->cr.plain) {
+		/* translate to the rotation center */
+		x -= gfx->cr.x;
+		y -= gfx->cr.y;
+		/* rotate, scale, shear and move */
+		xt = RXFORM(x, gfx->cr.xfrm[0][0], y, gfx->cr.xfrm[1][0], gfx->cr.xfrm[2][0]);
+		yt = RXFORM(x, gfx->cr.xfrm[0][1], y, gfx->cr.xfrm[1][1], gfx->cr.xfrm[2][1]);
+		/* translate back in the real world */
+		x = xt + gfx->cr.x;
+		y = yt + gfx->cr.y;
+	}
 #endif
 
 	/* now clip to the screen's actual size */
 	if ((x < 0) || (x >= gfx->w) ||
 	    (y < 0) || (y >= gfx->h)) {
-		if (gfx->flags & GFX_OOBREPORT) {
+#ifndef GFX_NO_OOBREPORT
+		if (OOB_REPORTING(gfx)) {
 			printf("Pixel [%d, %d] => [%d, %d] is out of bounds\n", save[0], save[1], x, y);
 		}
-		return; // off screen so don't draw it
+#endif
+		return 0; // off screen so don't draw it
+	}
+	/* and to the clip rectangle if there is one */
+	if ((gfx->flags & GFX_CLIP) &&
+		((x < gfx->clip.x0) || (x >= gfx->clip.x1) ||
+		 (y < gfx->clip.y0) || (y >= gfx->clip.y1))) {
+		return 0;
 	}
 
 	/*
@@ -143,8 +466,193 @@ __paint_pixel(GFX_CTX *gfx, int x, int y, GFX_COLOR color)
 		x = (gfx->w - 1) - x;
 	}
 
-	/* invoke user's callback in display co-ordinates */
-	(gfx->drawpixel)(gfx->fb, x, y, color);
+	if (gfx->flags & GFX_LAZY_CLEAR) {
+		__lazy_touch(gfx, x, y);
+	}
+	*px = x;
+	*py = y;
+	return 1;
+}
+
+static void
+__paint_pixel(GFX_CTX *gfx, int x, int y, GFX_COLOR color)
+{
+	if (__display_xy(gfx, &x, &y)) {
+		/* invoke user's callback in display co-ordinates */
+		(gfx->drawpixel)(gfx->fb, x, y, color);
+	}
+}
+
+/*
+ * __blend_pixel
+ *
+ * Paint a pixel that 'cov' (0 - 255) of is covered by the shape, for
+ * the anti-aliased drawing. The coverage is scaled by the color's
+ * alpha and handed to the blend function if there is one, blended
+ * straight into the pixel if the frame buffer is a GFX_BITMAP, or
+ * failing both the pixel is painted if it is at least half covered.
+ */
+static void
+__blend_pixel(GFX_CTX *gfx, int x, int y, GFX_COLOR color, int cov)
+{
+	GFX_COLOR	*p;
+	int			a;
+
+	a = (cov * (color.c.a + 1)) >> 8;
+	if ((a == 0) || (__display_xy(gfx, &x, &y) == 0)) {
+		return;
+	}
+	if (gfx->drawblend != NULL) {
+		(gfx->drawblend)(gfx->fb, x, y, color, a);
+	} else if (gfx->flags & GFX_FB_BITMAP) {
+		p = ((GFX_BITMAP *) gfx->fb)->pixels + y * ((GFX_BITMAP *) gfx->fb)->stride + x;
+		p->c.r += ((int) color.c.r - (int) p->c.r) * a / 255;
+		p->c.g += ((int) color.c.g - (int) p->c.g) * a / 255;
+		p->c.b += ((int) color.c.b - (int) p->c.b) * a / 255;
+	} else if (a >= 128) {
+		(gfx->drawpixel)(gfx->fb, x, y, color);
+	}
+}
+
+/* true if user space and display space line up (no transform) */
+#ifdef GFX_NO_ROTATION
+#define UNROTATED(g)	1
+#else
+#define UNROTATED(g)	((g)->cr.plain)
+#endif
+
+/*
+ * __paint_span
+ *
+ * Paint a horizontal run of pixels from [x0, y] to [x1, y]
+ * (inclusive) in user space. This is the building block for
+ * the filled shapes. When there is no rotation the run is
+ * still horizontal on the display so it can be clipped once
+ * and handed to the span function (or written straight into
+ * a bitmap), otherwise we fall back to pixel at a time.
+ */
+static void
+__paint_span(GFX_CTX *g, int x0, int x1, int y, GFX_COLOR color)
+{
+	GFX_BITMAP	*bm;
+	GFX_COLOR	*p;
+	int			x;
+
+	if (x0 > x1) {
+		x = x0; x0 = x1; x1 = x;
+	}
+	if (! UNROTATED(g) || OOB_REPORTING(g)) {
+		for (x = x0; x <= x1; x++) {
+			__paint_pixel(g, x, y, color);
+		}
+		return;
+	}
+
+	/* clip it once */
+	if ((y < 0) || (y >= g->h) || (x1 < 0) || (x0 >= g->w)) {
+		return;
+	}
+	x0 = (x0 < 0) ? 0 : x0;
+	x1 = (x1 >= g->w) ? g->w - 1 : x1;
+	if (g->flags & GFX_CLIP) {
+		if ((y < g->clip.y0) || (y >= g->clip.y1)) {
+			return;
+		}
+		x0 = (x0 < g->clip.x0) ? g->clip.x0 : x0;
+		x1 = (x1 >= g->clip.x1) ? g->clip.x1 - 1 : x1;
+		if (x0 > x1) {
+			return;
+		}
+	}
+	if ((g->flags & GFX_DISPLAY_INVERT_X) != 0) {
+		x = x0;
+		x0 = (g->w - 1) - x1;
+		x1 = (g->w - 1) - x;
+	}
+
+	if (g->flags & GFX_LAZY_CLEAR) {
+		for (x = x0; x <= x1; x = (x | (GFX_TILE_SIZE - 1)) + 1) {
+			__lazy_touch(g, x, y);
+		}
+	}
+
+	if (g->drawspan != NULL) {
+		(g->drawspan)(g->fb, x0, y, (x1 - x0) + 1, color);
+	} else if (g->flags & GFX_FB_BITMAP) {
+		bm = g->fb;
+		p = bm->pixels + y * bm->stride;
+		for (x = x0; x <= x1; x++) {
+			p[x] = color;
+		}
+	} else {
+		for (x = x0; x <= x1; x++) {
+			(g->drawpixel)(g->fb, x, y, color);
+		}
+	}
+}
+
+/*
+ * __paint_column
+ *
+ * The vertical version of __paint_span(), paint [x, y0] to [x, y1]
+ * (inclusive) in user space. Steep lines are made of these.
+ */
+static void
+__paint_column(GFX_CTX *g, int x, int y0, int y1, GFX_COLOR color)
+{
+	GFX_BITMAP	*bm;
+	GFX_COLOR	*p;
+	int			y;
+
+	if (y0 > y1) {
+		y = y0; y0 = y1; y1 = y;
+	}
+	if (! UNROTATED(g) || OOB_REPORTING(g)) {
+		for (y = y0; y <= y1; y++) {
+			__paint_pixel(g, x, y, color);
+		}
+		return;
+	}
+
+	/* clip it once */
+	if ((x < 0) || (x >= g->w) || (y1 < 0) || (y0 >= g->h)) {
+		return;
+	}
+	y0 = (y0 < 0) ? 0 : y0;
+	y1 = (y1 >= g->h) ? g->h - 1 : y1;
+	if (g->flags & GFX_CLIP) {
+		if ((x < g->clip.x0) || (x >= g->clip.x1)) {
+			return;
+		}
+		y0 = (y0 < g->clip.y0) ? g->clip.y0 : y0;
+		y1 = (y1 >= g->clip.y1) ? g->clip.y1 - 1 : y1;
+		if (y0 > y1) {
+			return;
+		}
+	}
+	if ((g->flags & GFX_DISPLAY_INVERT_X) != 0) {
+		x = (g->w - 1) - x;
+	}
+
+	if (g->flags & GFX_LAZY_CLEAR) {
+		for (y = y0; y <= y1; y = (y | (GFX_TILE_SIZE - 1)) + 1) {
+			__lazy_touch(g, x, y);
+		}
+	}
+
+	if (g->drawcolumn != NULL) {
+		(g->drawcolumn)(g->fb, x, y0, (y1 - y0) + 1, color);
+	} else if (g->flags & GFX_FB_BITMAP) {
+		bm = g->fb;
+		p = bm->pixels + y0 * bm->stride + x;
+		for (y = y0; y <= y1; y++, p += bm->stride) {
+			*p = color;
+		}
+	} else {
+		for (y = y0; y <= y1; y++) {
+			(g->drawpixel)(g->fb, x, y, color);
+		}
+	}
 }
 
 /*
@@ -159,7 +667,7 @@ __paint_pixel(GFX_CTX *gfx, int x, int y, GFX_COLOR color)
  */
 static void
 __paint_line(GFX_CTX *g, int x0, int y0, int x1, int y1, GFX_COLOR color) {
-	int mx, my, e;
+	int mx, my, e, n, run, step;
 	int da = abs(x1 - x0) > abs(y1 - y0);
 
 	/* One pixel line if the destination is the same */
@@ -175,24 +683,12 @@ __paint_line(GFX_CTX *g, int x0, int y0, int x1, int y1, GFX_COLOR color) {
  	 * the display if a rotation has been applied.
 	 */
 	if (x0 == x1) {
-		if (y0 > y1) {
-			e = y0; y0 = y1; y1 = e;
-		}
-		while (y0 <= y1) {
-			__paint_pixel(g, x0, y0, color);
-			y0++;
-		}
+		__paint_column(g, x0, y0, y1, color);
 		return;
 	}
 
 	if (y0 == y1) {
-		if (x0 > x1) {
-			e = x0; x0 = x1; x1 = e;
-		}
-		while (x0 <= x1) {
-			__paint_pixel(g, x0, y0, color);
-			x0 ++;
-		}
+		__paint_span(g, x0, x1, y0, color);
 		return;
 	}
 
@@ -201,9 +697,15 @@ __paint_line(GFX_CTX *g, int x0, int y0, int x1, int y1, GFX_COLOR color) {
 	 *
 	 * DA == TRUE (x is the driving axis)
 	 *       FALSE (y is the driving axis)
- 	 * TODO Could collapse the drawing part and just swap
-	 *		x,y in the __paint_pixel call based on DA if
-	 * 		I wanted.
+	 *
+	 * Rather than a pixel at a time the line is painted a run
+	 * at a time (run slice). Along the driving axis the error
+	 * term goes up by the minor length for each pixel and the
+	 * minor axis steps when it goes positive, so from the error
+	 * at the start of a run the length of the run is a divide.
+	 * The pixels are the same ones the pixel at a time version
+	 * painted, but a shallow line is one span per row and a
+	 * steep one is one column per column.
 	 */
 	if (da) {
 		/* if X1 is left of X0, swap co-ords */
@@ -217,15 +719,16 @@ __paint_line(GFX_CTX *g, int x0, int y0, int x1, int y1, GFX_COLOR color) {
 		}
 		mx = x1 - x0;
 		my = abs(y1 - y0);
+		step = (y0 > y1) ? -1 : 1;
 		e = my - mx;
-		while (x0 <= x1) {
-			__paint_pixel(g, x0, y0, color);
-			x0++;
-			e += my; 
-			if (e > 0) {
-				y0 += (y0 > y1) ? -1 : 1;
-				e -= mx;
-			}
+		for (n = mx + 1; n > 0; n -= run) {
+			/* e <= 0 here, pixels until it goes positive */
+			run = (-e) / my + 1;
+			run = (run > n) ? n : run;
+			__paint_span(g, x0, x0 + run - 1, y0, color);
+			x0 += run;
+			e += run * my - mx;
+			y0 += step;
 		}
 	} else {
 		/* swap coords if Y1 is less than Y0 */
@@ -239,15 +742,15 @@ __paint_line(GFX_CTX *g, int x0, int y0, int x1, int y1, GFX_COLOR color) {
 		}
 		my = y1 - y0;
 		mx = abs(x1 - x0);
+		step = (x0 > x1) ? -1 : 1;
 		e = mx - my;
-		while (y0 <= y1) {
-			__paint_pixel(g, x0, y0, color);
-			y0++;
-			e += mx; 
-			if (e > 0) {
-				x0 += (x0 > x1) ? -1 : 1;
-				e -= my;
-			}
+		for (n = my + 1; n > 0; n -= run) {
+			run = (-e) / mx + 1;
+			run = (run > n) ? n : run;
+			__paint_column(g, x0, y0, y0 + run - 1, color);
+			y0 += run;
+			e += run * mx - my;
+			x0 += step;
 		}
 	}
 	return;
@@ -456,47 +959,758 @@ __paint_triangle(GFX_CTX *g, int x0, int y0, int x1, int y1, int x2, int y2, GFX
 }
 
 /*
- * gfx_rotate( ... )
- *
- * This sets the display rotation by creating a
- * 2 x 2 transform that is used in the pixel
- * painting function to adjust x and y from
- * user space to display space.
- *
- * Transform is :
- *            +-------+--------+
- *   [X, Y]   | cos a | -sin a |
- *            +-------+--------+
- *        	  | sin a | cos a  |
- *            +-------+--------+
+ * Polygon edges for the scanline fill. Each edge walks down
+ * the scanlines keeping its x crossing exactly as a whole part
+ * plus a fraction (num / dy) so there is no drift, and pixel
+ * [x, y] is inside the span if its x is >= the left crossing
+ * and < the right crossing. Scanlines from the top vertex down
+ * to (but not including) the bottom vertex are covered. That is
+ * the usual top-left rule, so polygons that share an edge don't
+ * paint the pixels along that edge twice.
  */
-void
-gfx_rotate(GFX_CTX *g, float angle)
+struct __edge {
+	int		y0, y1;		/* first scanline, one past the last */
+	int		xa, ya;		/* top vertex */
+	int		dx, dy;		/* dy is always > 0 */
+	int		x, num;		/* crossing is x + num / dy */
+	int		q, r;		/* step per scanline, q + r / dy */
+	int		dir;		/* +1 edge runs down, -1 it runs up */
+};
+
+/* set up an edge between two vertices, returns 0 if horizontal */
+static int
+__edge_setup(struct __edge *e, int x0, int y0, int x1, int y1)
 {
-	g->cr.xfrm[0][0] = g->cr.xfrm[1][1] = cos((angle * M_PI) / 180.0);
-	g->cr.xfrm[0][1] = -sin((angle * M_PI) / 180.0);
-	g->cr.xfrm[1][0] = - g->cr.xfrm[0][1];
+	if (y0 == y1) {
+		return 0;
+	}
+	e->dir = 1;
+	if (y0 > y1) {
+		e->dir = -1;
+		swap(x0, x1);
+		swap(y0, y1);
+	}
+	e->xa = x0; e->ya = y0;
+	e->y0 = y0; e->y1 = y1;
+	e->dx = x1 - x0;
+	e->dy = y1 - y0;
+	/* floor division so the remainder is never negative */
+	e->q = e->dx / e->dy;
+	e->r = e->dx % e->dy;
+	if (e->r < 0) {
+		e->q--;
+		e->r += e->dy;
+	}
+	return 1;
 }
 
-/*
- * gfx_set_rotation_origin( ... )
- *
- * Set the center of rotation for the display.
- * By default it is the center of the display
- * but at times you might want it somewhere else.
- *
- * NB: Because the display is an even number of lines
- * and pixels this usually works. But on bitmaps that
- * are an odd number of lines or pixels it can create
- * subtle artifacts.
- */
-void
-gfx_set_rotation_origin(GFX_CTX *g, int x, int y)
+/* position an edge on scanline y */
+static void
+__edge_start(struct __edge *e, int y)
+{
+	int64_t	t = (int64_t)(y - e->ya) * e->dx;
+	int64_t	f = t / e->dy;
+
+	if ((t % e->dy) < 0) {
+		f--;
+	}
+	e->x = e->xa + (int) f;
+	e->num = (int)(t - f * e->dy);
+}
+
+/* move an edge down one scanline */
+static inline void
+__edge_step(struct __edge *e)
+{
+	e->x += e->q;
+	e->num += e->r;
+	if (e->num >= e->dy) {
+		e->x++;
+		e->num -= e->dy;
+	}
+}
+
+/* first pixel at or to the right of the crossing */
+#define EDGE_CEIL(e)	((e)->x + ((e)->num != 0))
+
+/* is edge a's crossing left of edge b's? */
+static inline int
+__edge_less(struct __edge *a, struct __edge *b)
+{
+	if (a->x != b->x) {
+		return a->x < b->x;
+	}
+	return ((int64_t) a->num * b->dy) < ((int64_t) b->num * a->dy);
+}
+
+/*
+ * __paint_convex
+ *
+ * Fast path for convex polygons, there is exactly one edge
+ * on the left and one on the right for every scanline so we
+ * just walk the two chains down from the top vertex.
+ */
+static void
+__paint_convex(GFX_CTX *g, const int *pts, int n, int top, int ymin, int ymax, GFX_COLOR color)
+{
+	struct __edge	l = { 0 }, r = { 0 };
+	int	li, ri, ln, rn;
+	int	y, xl, xr;
+
+	if (UNROTATED(g)) {
+		ymin = (ymin < 0) ? 0 : ymin;
+		ymax = (ymax > g->h) ? g->h : ymax;
+	}
+	li = ri = top;
+	l.y1 = r.y1 = ymin;
+	for (y = ymin; y < ymax; y++) {
+		/* move on to the next edge of each chain as needed */
+		while (l.y1 <= y) {
+			ln = (li + n - 1) % n;
+			if (__edge_setup(&l, pts[li * 2], pts[li * 2 + 1],
+							     pts[ln * 2], pts[ln * 2 + 1])) {
+				__edge_start(&l, y);
+			}
+			li = ln;
+		}
+		while (r.y1 <= y) {
+			rn = (ri + 1) % n;
+			if (__edge_setup(&r, pts[ri * 2], pts[ri * 2 + 1],
+							     pts[rn * 2], pts[rn * 2 + 1])) {
+				__edge_start(&r, y);
+			}
+			ri = rn;
+		}
+		xl = EDGE_CEIL(&l);
+		xr = EDGE_CEIL(&r);
+		if (xl > xr) {
+			swap(xl, xr);
+		}
+		if (xl < xr) {
+			__paint_span(g, xl, xr - 1, y, color);
+		}
+		__edge_step(&l);
+		__edge_step(&r);
+	}
+}
+
+/*
+ * __paint_polygon
+ *
+ * Scanline polygon fill with an active edge table. The edges
+ * are sorted by their top scanline, as each scanline is reached
+ * the edges that start on it join the active table and the ones
+ * that end leave it. The active edges are kept sorted by where
+ * they cross the scanline and spans are painted between them
+ * following the even-odd rule or, if GFX_FILL_NONZERO is set,
+ * the non-zero winding rule.
+ *
+ * Convex polygons are detected and handed to __paint_convex, which
+ * takes any number of vertices. The edge tables here only have room
+ * for GFX_POLY_MAX, returns -1 if there are more than that.
+ */
+static int
+__paint_polygon(GFX_CTX *g, const int *pts, int n, GFX_COLOR color)
+{
+	struct __edge	et[GFX_POLY_MAX];		/* edge table */
+	struct __edge	*aet[GFX_POLY_MAX];		/* active edges */
+	struct __edge	*t;
+	int	ne = 0, na = 0, next = 0;
+	int	i, j, k, y, ymin, ymax, top;
+	int	cross, turn = 0, ydir = 0, flips = 0, wind, x0;
+
+	if (n < 3) {
+		return 0;
+	}
+
+	/*
+	 * Look for convexity while finding the top and bottom. A
+	 * polygon is convex if it always turns the same way and
+	 * only changes vertical direction twice (so it doesn't
+	 * wrap around on itself like a star does).
+	 */
+	ymin = ymax = pts[1];
+	top = 0;
+	for (i = 0; i < n; i++) {
+		j = (i + 1) % n;
+		k = (i + 2) % n;
+		if (pts[i * 2 + 1] < ymin) {
+			ymin = pts[i * 2 + 1];
+			top = i;
+		}
+		if (pts[i * 2 + 1] > ymax) {
+			ymax = pts[i * 2 + 1];
+		}
+		cross = (pts[j * 2] - pts[i * 2]) * (pts[k * 2 + 1] - pts[j * 2 + 1]) -
+				(pts[j * 2 + 1] - pts[i * 2 + 1]) * (pts[k * 2] - pts[j * 2]);
+		if (cross != 0) {
+			if ((turn != 0) && ((cross > 0) != (turn > 0))) {
+				flips = 3;		/* turned both ways, not convex */
+			}
+			turn = cross;
+		}
+		if (pts[j * 2 + 1] != pts[i * 2 + 1]) {
+			if ((ydir != 0) && ((pts[j * 2 + 1] > pts[i * 2 + 1]) != (ydir > 0))) {
+				flips++;
+			}
+			ydir = pts[j * 2 + 1] - pts[i * 2 + 1];
+		}
+	}
+	if (ymin == ymax) {
+		return 0;		/* no area */
+	}
+	if (flips <= 2) {
+		__paint_convex(g, pts, n, top, ymin, ymax, color);
+		return 0;
+	}
+	if (n > GFX_POLY_MAX) {
+		return -1;
+	}
+
+	/* build the edge table, sorted by top scanline */
+	for (i = 0; i < n; i++) {
+		j = (i + 1) % n;
+		if (__edge_setup(&et[ne], pts[i * 2], pts[i * 2 + 1],
+								  pts[j * 2], pts[j * 2 + 1])) {
+			for (k = ne; (k > 0) && (et[k - 1].y0 > et[k].y0); k--) {
+				struct __edge tmp = et[k];
+				et[k] = et[k - 1];
+				et[k - 1] = tmp;
+			}
+			ne++;
+		}
+	}
+
+	y = ymin;
+	if (UNROTATED(g)) {
+		y = (y < 0) ? 0 : y;
+		ymax = (ymax > g->h) ? g->h : ymax;
+	}
+	for (; y < ymax; y++) {
+		/* drop edges that have ended, step the rest */
+		for (i = 0, j = 0; i < na; i++) {
+			if (aet[i]->y1 > y) {
+				aet[j++] = aet[i];
+			}
+		}
+		na = j;
+		/* add edges that start here (or above, if we clipped) */
+		while ((next < ne) && (et[next].y0 <= y)) {
+			if (et[next].y1 > y) {
+				__edge_start(&et[next], y);
+				aet[na++] = &et[next];
+			}
+			next++;
+		}
+		/* keep them sorted by crossing, they are nearly sorted already */
+		for (i = 1; i < na; i++) {
+			t = aet[i];
+			for (j = i; (j > 0) && __edge_less(t, aet[j - 1]); j--) {
+				aet[j] = aet[j - 1];
+			}
+			aet[j] = t;
+		}
+		/* paint the spans */
+		wind = 0;
+		for (i = 0; i < na; i++) {
+			if (g->flags & GFX_FILL_NONZERO) {
+				if (wind == 0) {
+					x0 = EDGE_CEIL(aet[i]);
+				}
+				wind += aet[i]->dir;
+				if ((wind == 0) && (EDGE_CEIL(aet[i]) > x0)) {
+					__paint_span(g, x0, EDGE_CEIL(aet[i]) - 1, y, color);
+				}
+			} else if ((i & 1) && (EDGE_CEIL(aet[i]) > EDGE_CEIL(aet[i - 1]))) {
+				__paint_span(g, EDGE_CEIL(aet[i - 1]), EDGE_CEIL(aet[i]) - 1, y, color);
+			}
+		}
+		for (i = 0; i < na; i++) {
+			__edge_step(aet[i]);
+		}
+	}
+	return 0;
+}
+
+/*
+ * Triangle meshes. For a mesh every edge is set up once, in a
+ * canonical direction (lower vertex index first), and kept in a
+ * small cache keyed by its two vertex indices so the triangle on
+ * the other side of it can reuse the setup. The edge function
+ * E(x, y) = a * x + b * y + c is positive on the inside of an
+ * edge walked in the triangle's winding order, a triangle using
+ * the edge the other way round just negates it.
+ *
+ * Pixels exactly on an edge go to the triangle for which it is a
+ * top or left edge. An edge is top or left in exactly one of its
+ * two directions so the pixels along a shared edge are painted
+ * once, with no gaps and no double painting.
+ */
+#define MESH_CACHE	32
+
+struct __mesh_edge {
+	int	i, j;		/* vertex indices, i < j, -1 if empty */
+	int	a, b, c;	/* edge function walking i -> j */
+	int	tl;			/* i -> j is a top or left edge */
+};
+
+static struct __mesh_edge *
+__mesh_edge(struct __mesh_edge *cache, const int *v, int i, int j)
+{
+	struct __mesh_edge *e;
+	int dx, dy;
+
+	if (i > j) {
+		swap(i, j);
+	}
+	e = &cache[((unsigned) i * 31u + (unsigned) j) & (MESH_CACHE - 1)];
+	if ((e->i != i) || (e->j != j)) {
+		dx = v[j * 2] - v[i * 2];
+		dy = v[j * 2 + 1] - v[i * 2 + 1];
+		e->i = i;
+		e->j = j;
+		e->a = -dy;
+		e->b = dx;
+		e->c = v[i * 2] * v[j * 2 + 1] - v[j * 2] * v[i * 2 + 1];
+		/* y is down, so a 'top' edge runs left to right */
+		e->tl = (dy < 0) || ((dy == 0) && (dx > 0));
+	}
+	return e;
+}
+
+/* floor of n / d for d > 0 */
+static inline int
+__floor_div(int n, int d)
+{
+	return (n >= 0) ? (n / d) : -((-n + d - 1) / d);
+}
+
+/*
+ * Walks floor((n + m * i) / d), d > 0, for i = 0, 1, 2 ... The
+ * quotient and remainder are carried from one i to the next so a
+ * step is a couple of adds rather than a divide.
+ */
+struct __floor_step {
+	int	q, r;		/* the quotient, and 0 <= r < d left over */
+	int	mq, mr;		/* m / d split the same way */
+	int	d;
+};
+
+static void
+__floor_step_init(struct __floor_step *s, int n, int m, int d)
+{
+	s->d = d;
+	s->q = __floor_div(n, d);
+	s->r = n - s->q * d;
+	s->mq = __floor_div(m, d);
+	s->mr = m - s->mq * d;
+}
+
+static inline void
+__floor_step(struct __floor_step *s)
+{
+	s->q += s->mq;
+	s->r += s->mr;
+	if (s->r >= s->d) {
+		s->q++;
+		s->r -= s->d;
+	}
+}
+
+/*
+ * __paint_mesh
+ *
+ * Fill 'count' triangles, each is three indices into 'v'. Each
+ * triangle is clipped to the screen by its bounding box (when
+ * the display isn't rotated) and then each scanline's span is
+ * worked out from the three edge functions. Where an edge crosses
+ * the first row takes a divide, after that it is stepped down a
+ * row at a time.
+ */
+static void
+__paint_mesh(GFX_CTX *g, const int *v, const int *idx, int count, GFX_COLOR color)
+{
+	struct __mesh_edge	cache[MESH_CACHE];
+	struct __mesh_edge	*e;
+	int		a[3], b[3], c[3];
+	int		t, k, i0, i1, i2, y, x0, x1;
+	int		minx, maxx, miny, maxy;
+	struct __floor_step	lim[3];
+
+	for (k = 0; k < MESH_CACHE; k++) {
+		cache[k].i = cache[k].j = -1;
+	}
+	for (t = 0; t < count; t++, idx += 3) {
+		i0 = idx[0];
+		i1 = idx[1];
+		i2 = idx[2];
+		minx = min(v[i0 * 2], v[i1 * 2], v[i2 * 2]);
+		maxx = max(v[i0 * 2], v[i1 * 2], v[i2 * 2]);
+		miny = min(v[i0 * 2 + 1], v[i1 * 2 + 1], v[i2 * 2 + 1]);
+		maxy = max(v[i0 * 2 + 1], v[i1 * 2 + 1], v[i2 * 2 + 1]);
+		if (UNROTATED(g)) {
+			/* cheap reject for triangles that are off the screen */
+			minx = (minx < 0) ? 0 : minx;
+			miny = (miny < 0) ? 0 : miny;
+			maxx = (maxx >= g->w) ? g->w - 1 : maxx;
+			maxy = (maxy >= g->h) ? g->h - 1 : maxy;
+			if ((minx > maxx) || (miny > maxy)) {
+				continue;
+			}
+		}
+
+		/* wind it so the inside is positive, skip it if it has no area */
+		k = (v[i1 * 2] - v[i0 * 2]) * (v[i2 * 2 + 1] - v[i0 * 2 + 1]) -
+			(v[i1 * 2 + 1] - v[i0 * 2 + 1]) * (v[i2 * 2] - v[i0 * 2]);
+		if (k == 0) {
+			continue;
+		}
+		if (k < 0) {
+			swap(i1, i2);
+		}
+		for (k = 0; k < 3; k++) {
+			int from = (k == 0) ? i0 : ((k == 1) ? i1 : i2);
+			int to = (k == 0) ? i1 : ((k == 1) ? i2 : i0);
+
+			e = __mesh_edge(cache, v, from, to);
+			if (from == e->i) {
+				a[k] = e->a; b[k] = e->b; c[k] = e->c - ! e->tl;
+			} else {
+				a[k] = -e->a; b[k] = -e->b; c[k] = -e->c - e->tl;
+			}
+		}
+
+		/*
+		 * A pixel is in if a * x + b * y + c >= 0 for all three, so
+		 * each edge limits x to one side of (b * y + c) / -a. For a
+		 * flat edge (a == 0) the step just tracks b * y + c.
+		 */
+		for (k = 0; k < 3; k++) {
+			__floor_step_init(&lim[k], b[k] * miny + c[k], b[k],
+				(a[k] == 0) ? 1 : abs(a[k]));
+		}
+		for (y = miny; y <= maxy; y++) {
+			x0 = minx;
+			x1 = maxx;
+			for (k = 0; k < 3; k++) {
+				if (a[k] > 0) {
+					x0 = (-lim[k].q > x0) ? -lim[k].q : x0;
+				} else if (a[k] < 0) {
+					x1 = (lim[k].q < x1) ? lim[k].q : x1;
+				} else if (lim[k].q < 0) {
+					x1 = x0 - 1;
+				}
+				__floor_step(&lim[k]);
+			}
+			if (x0 <= x1) {
+				__paint_span(g, x0, x1, y, color);
+			}
+		}
+	}
+}
+
+#ifdef GFX_NO_FLOAT
+/*
+ * sin() of each whole degree from 0 to 90 in 16.16 fixed point, the
+ * rest of the circle is folded onto these.
+ */
+static const int32_t __sin_table[91] = {
+	0, 1144, 2287, 3430, 4572, 5712, 6850, 7987,
+	9121, 10252, 11380, 12505, 13626, 14742, 15855, 16962,
+	18064, 19161, 20252, 21336, 22415, 23486, 24550, 25607,
+	26656, 27697, 28729, 29753, 30767, 31772, 32768, 33754,
+	34729, 35693, 36647, 37590, 38521, 39441, 40348, 41243,
+	42126, 42995, 43852, 44695, 45525, 46341, 47143, 47930,
+	48703, 49461, 50203, 50931, 51643, 52339, 53020, 53684,
+	54332, 54963, 55578, 56175, 56756, 57319, 57865, 58393,
+	58903, 59396, 59870, 60326, 60764, 61183, 61584, 61966,
+	62328, 62672, 62997, 63303, 63589, 63856, 64104, 64332,
+	64540, 64729, 64898, 65048, 65177, 65287, 65376, 65446,
+	65496, 65526, 65536,
+};
+
+/*
+ * sin() of 'a' in 1/256ths of a degree, as 16.16 fixed point. Whole
+ * degrees come straight out of the table (so right angles are exact),
+ * in between is a straight line between the two neighbours.
+ */
+static GFX_REAL
+__sin_fix(int32_t a)
+{
+	int32_t	d, f, r;
+	int		neg = 0;
+
+	a %= 360 * 256;
+	if (a < 0) {
+		a += 360 * 256;
+	}
+	if (a >= 180 * 256) {
+		a -= 180 * 256;
+		neg = 1;
+	}
+	if (a > 90 * 256) {
+		a = 180 * 256 - a;
+	}
+	d = a >> 8;
+	f = a & 0xff;
+	r = __sin_table[d];
+	if (f != 0) {
+		r += ((__sin_table[d + 1] - r) * f) >> 8;
+	}
+	return (neg) ? -r : r;
+}
+#endif
+
+#ifndef GFX_NO_ROTATION
+/* a float argument as a GFX_REAL, rounded */
+#ifdef GFX_NO_FLOAT
+#define FLOAT_REAL(f)	((GFX_REAL) (((f) < 0) ? (f) * 65536 - 0.5f : (f) * 65536 + 0.5f))
+#else
+#define FLOAT_REAL(f)	(f)
+#endif
+#endif
+
+#if !defined(GFX_NO_ROTATION) || !defined(GFX_NO_TEXT_ROTATION)
+/*
+ * Fill in a rotation matrix for 'angle' degrees, with nothing in
+ * the move row. With GFX_NO_FLOAT this is the only place the angle
+ * is looked at as a float, it is turned into 1/256ths of a degree
+ * and the rest is table lookups. With floats the right angles are
+ * made exact, cos(90) isn't quite 0 and those would otherwise creep
+ * into every transform built on them.
+ */
+static void
+__rotation(GFX_REAL xfrm[3][2], float angle)
+{
+#ifdef GFX_NO_FLOAT
+	int32_t	a = (int32_t) ((angle < 0) ? angle * 256 - 0.5f : angle * 256 + 0.5f);
+
+	xfrm[0][0] = xfrm[1][1] = __sin_fix(a + 90 * 256);
+	xfrm[0][1] = -__sin_fix(a);
+#else
+	static const float	quad[4] = { 0, 1, 0, -1 };
+	long	q = (long) angle;
+
+	if ((angle == (float) q) && ((q % 90) == 0)) {
+		q = ((q / 90) % 4 + 4) % 4;
+		xfrm[0][0] = xfrm[1][1] = quad[(q + 1) % 4];
+		xfrm[0][1] = -quad[q];
+	} else {
+		xfrm[0][0] = xfrm[1][1] = cos((angle * M_PI) / 180.0);
+		xfrm[0][1] = -sin((angle * M_PI) / 180.0);
+	}
+#endif
+	xfrm[1][0] = - xfrm[0][1];
+	xfrm[2][0] = xfrm[2][1] = 0;
+}
+#endif
+
+#ifndef GFX_NO_ROTATION
+/* note whether the transform does anything */
+static void
+__check_plain(GFX_TRANSFORM *t)
+{
+	t->plain = (t->xfrm[0][0] == GFX_REAL_ONE) && (t->xfrm[0][1] == 0) &&
+			   (t->xfrm[1][0] == 0) && (t->xfrm[1][1] == GFX_REAL_ONE) &&
+			   (t->xfrm[2][0] == 0) && (t->xfrm[2][1] == 0);
+}
+
+/*
+ * Add the transform 'a' to the display transform, so that it is
+ * applied to what is drawn before the one that is already there.
+ * The current one works about the rotation origin O, so in display
+ * space p goes to L(p - O) + O + t. With a in front of it that is
+ * (L a)(p - O) + L(a(O) - O) + O + t, which is the new L and t.
+ */
+static void
+__compose(GFX_CTX *g, GFX_REAL a[3][2])
+{
+	GFX_TRANSFORM	*t = &g->cr;
+	GFX_REAL		l[2][2], ox = GFX_REAL_INT(t->x), oy = GFX_REAL_INT(t->y);
+	GFX_REAL		vx, vy;
+	int				i;
+
+	memcpy(l, t->xfrm, sizeof(l));
+	/* how far a moves the origin */
+	vx = RMUL(ox, a[0][0]) + RMUL(oy, a[1][0]) + a[2][0] - ox;
+	vy = RMUL(ox, a[0][1]) + RMUL(oy, a[1][1]) + a[2][1] - oy;
+	t->xfrm[2][0] += RMUL(vx, l[0][0]) + RMUL(vy, l[1][0]);
+	t->xfrm[2][1] += RMUL(vx, l[0][1]) + RMUL(vy, l[1][1]);
+	for (i = 0; i < 2; i++) {
+		t->xfrm[i][0] = RMUL(a[i][0], l[0][0]) + RMUL(a[i][1], l[1][0]);
+		t->xfrm[i][1] = RMUL(a[i][0], l[0][1]) + RMUL(a[i][1], l[1][1]);
+	}
+	__check_plain(t);
+}
+
+/*
+ * gfx_rotate( ... )
+ *
+ * This sets the display rotation by creating a
+ * 2 x 2 transform that is used in the pixel
+ * painting function to adjust x and y from
+ * user space to display space. It replaces the
+ * whole transform, so it also undoes any move,
+ * scale or shear.
+ *
+ * Transform is :
+ *            +-------+--------+
+ *   [X, Y]   | cos a | -sin a |
+ *            +-------+--------+
+ *        	  | sin a | cos a  |
+ *            +-------+--------+
+ */
+void
+gfx_rotate(GFX_CTX *g, float angle)
+{
+	__rotation(g->cr.xfrm, angle);
+	__check_plain(&g->cr);
+}
+
+/*
+ * gfx_set_rotation_origin( ... )
+ *
+ * Set the center of rotation for the display.
+ * By default it is the center of the display
+ * but at times you might want it somewhere else.
+ *
+ * NB: Because the display is an even number of lines
+ * and pixels this usually works. But on bitmaps that
+ * are an odd number of lines or pixels it can create
+ * subtle artifacts.
+ */
+void
+gfx_set_rotation_origin(GFX_CTX *g, int x, int y)
 {
 	g->cr.x = x;
 	g->cr.y = y;
 }
 
+/*
+ * gfx_translate( ... )
+ *
+ * Move everything drawn from here on 'dx' pixels right and 'dy'
+ * down (in user space, if the display is rotated so is the move).
+ */
+void
+gfx_translate(GFX_CTX *g, int dx, int dy)
+{
+	GFX_REAL	a[3][2] = {
+		{ GFX_REAL_ONE, 0 }, { 0, GFX_REAL_ONE }, { GFX_REAL_INT(dx), GFX_REAL_INT(dy) }
+	};
+
+	__compose(g, a);
+}
+
+/*
+ * gfx_scale( ... )
+ *
+ * Scale everything drawn from here on by 'sx' across and 'sy' down,
+ * about [0, 0] in user space. Pixels are still moved one at a time,
+ * so scaling up leaves gaps between them. It is meant for shrinking
+ * and for flipping (a scale of -1 mirrors).
+ */
+void
+gfx_scale(GFX_CTX *g, float sx, float sy)
+{
+	GFX_REAL	a[3][2] = {
+		{ FLOAT_REAL(sx), 0 }, { 0, FLOAT_REAL(sy) }, { 0, 0 }
+	};
+
+	__compose(g, a);
+}
+
+/*
+ * gfx_rotate_by( ... )
+ *
+ * Turn everything drawn from here on by 'angle' degrees about
+ * [0, 0] in user space, on top of whatever transform there is. To
+ * turn a gauge needle about its pivot translate to the pivot, turn,
+ * and draw the needle from [0, 0].
+ */
+void
+gfx_rotate_by(GFX_CTX *g, float angle)
+{
+	GFX_REAL	a[3][2];
+
+	__rotation(a, angle);
+	__compose(g, a);
+}
+
+/*
+ * gfx_shear( ... )
+ *
+ * Slant everything drawn from here on, x moves by 'shx' times y and
+ * y by 'shy' times x (about [0, 0] in user space). A shx of -0.25 is
+ * a passable italic.
+ */
+void
+gfx_shear(GFX_CTX *g, float shx, float shy)
+{
+	GFX_REAL	a[3][2] = {
+		{ GFX_REAL_ONE, FLOAT_REAL(shy) }, { FLOAT_REAL(shx), GFX_REAL_ONE }, { 0, 0 }
+	};
+
+	__compose(g, a);
+}
+#endif /* GFX_NO_ROTATION */
+
+/*
+ * gfx_push_state( ... )
+ *
+ * Save the transform, the text rotation, the clip rectangle and the
+ * text colors, so a widget can change them and gfx_pop_state() puts
+ * them back. Nothing is worked out again on the pop. Returns -1 (and
+ * saves nothing) if GFX_STATE_DEPTH states are already saved.
+ */
+int
+gfx_push_state(GFX_CTX *g)
+{
+	GFX_STATE	*s;
+
+	if (g->depth >= GFX_STATE_DEPTH) {
+		return -1;
+	}
+	s = &g->stack[g->depth++];
+	s->cr = g->cr;
+	s->text_cr = g->text.cr;
+	s->clip[0] = g->clip.x0;
+	s->clip[1] = g->clip.y0;
+	s->clip[2] = g->clip.x1;
+	s->clip[3] = g->clip.y1;
+	s->clipped = g->flags & GFX_CLIP;
+	s->fg = g->text.fg;
+	s->bg = g->text.bg;
+	return 0;
+}
+
+/*
+ * gfx_pop_state( ... )
+ *
+ * Go back to the state saved by the last gfx_push_state(). Returns
+ * -1 if there isn't one.
+ */
+int
+gfx_pop_state(GFX_CTX *g)
+{
+	GFX_STATE	*s;
+
+	if (g->depth <= 0) {
+		return -1;
+	}
+	s = &g->stack[--g->depth];
+	g->cr = s->cr;
+	g->text.cr = s->text_cr;
+	g->clip.x0 = s->clip[0];
+	g->clip.y0 = s->clip[1];
+	g->clip.x1 = s->clip[2];
+	g->clip.y1 = s->clip[3];
+	g->flags = (g->flags & ~GFX_CLIP) | s->clipped;
+	g->text.fg = s->fg;
+	g->text.bg = s->bg;
+	return 0;
+}
+
 /*
  * Drop a single colored pixel at the current
  * location.
@@ -530,6 +1744,98 @@ gfx_draw_point_at(GFX_CTX *gfx, int x, int y, GFX_COLOR color) {
 	gfx->cy = y;
 }
 
+/*
+ * The part of the display an unrotated context can be drawn on,
+ * the screen or the clip rectangle if there is one. x1 and y1 are
+ * just past the edge.
+ */
+static void
+__draw_box(GFX_CTX *g, int *x0, int *y0, int *x1, int *y1)
+{
+	*x0 = 0; *y0 = 0;
+	*x1 = g->w; *y1 = g->h;
+	if (g->flags & GFX_CLIP) {
+		*x0 = g->clip.x0; *y0 = g->clip.y0;
+		*x1 = g->clip.x1; *y1 = g->clip.y1;
+	}
+}
+
+/*
+ * gfx_draw_points( ... )
+ *
+ * Draw 'n' points, 'xy' holds them as x, y pairs. The cursor isn't
+ * moved. When the display isn't rotated the clipping is worked out
+ * once and each point is just a compare and a store.
+ */
+void
+gfx_draw_points(GFX_CTX *g, const int *xy, int n, GFX_COLOR color)
+{
+	GFX_BITMAP	*bm = g->fb;
+	int			i, x, y, bx0, by0, bx1, by1;
+
+	if (! UNROTATED(g) || OOB_REPORTING(g)) {
+		for (i = 0; i < n; i++) {
+			__paint_pixel(g, xy[2 * i], xy[2 * i + 1], color);
+		}
+		return;
+	}
+	__draw_box(g, &bx0, &by0, &bx1, &by1);
+	for (i = 0; i < n; i++) {
+		x = xy[2 * i];
+		y = xy[2 * i + 1];
+		if ((x < bx0) || (x >= bx1) || (y < by0) || (y >= by1)) {
+			continue;
+		}
+		if (g->flags & GFX_DISPLAY_INVERT_X) {
+			x = (g->w - 1) - x;
+		}
+		if (g->flags & GFX_LAZY_CLEAR) {
+			__lazy_touch(g, x, y);
+		}
+		if (g->flags & GFX_FB_BITMAP) {
+			bm->pixels[y * bm->stride + x] = color;
+		} else {
+			(g->drawpixel)(g->fb, x, y, color);
+		}
+	}
+}
+
+/*
+ * gfx_draw_segments( ... )
+ *
+ * Draw 'n' separate lines, 'xy' holds x0, y0, x1, y1 for each of
+ * them. The cursor isn't moved. Lines that are entirely off one
+ * side of the screen (or clip rectangle) are skipped without being
+ * drawn and horizontal ones are drawn as spans.
+ */
+void
+gfx_draw_segments(GFX_CTX *g, const int *xy, int n, GFX_COLOR color)
+{
+	const int	*s;
+	int			i, bx0, by0, bx1, by1;
+
+	if (! UNROTATED(g) || OOB_REPORTING(g)) {
+		for (i = 0; i < n; i++) {
+			s = xy + 4 * i;
+			__paint_line(g, s[0], s[1], s[2], s[3], color);
+		}
+		return;
+	}
+	__draw_box(g, &bx0, &by0, &bx1, &by1);
+	for (i = 0; i < n; i++) {
+		s = xy + 4 * i;
+		if (((s[0] < bx0) && (s[2] < bx0)) || ((s[0] >= bx1) && (s[2] >= bx1)) ||
+			((s[1] < by0) && (s[3] < by0)) || ((s[1] >= by1) && (s[3] >= by1))) {
+			continue;
+		}
+		if (s[1] == s[3]) {
+			__paint_span(g, s[0], s[2], s[1], color);
+		} else {
+			__paint_line(g, s[0], s[1], s[2], s[3], color);
+		}
+	}
+}
+
 /*
  * gfx_move_to( ... )
  *
@@ -645,24 +1951,563 @@ gfx_draw_circle_at(GFX_CTX *g, int x, int y, int r, GFX_COLOR color) {
  * radius 'r'.
  */
 void
-gfx_fill_circle(GFX_CTX *g, int r, GFX_COLOR color) {
-	if (r <= 0) {
-		return;
+gfx_fill_circle(GFX_CTX *g, int r, GFX_COLOR color) {
+	if (r <= 0) {
+		return;
+	}
+	__paint_quadrant(g, g->cx, g->cy, r, 0xf, 1, color);
+}
+
+/*
+ * gfx_fill_circle_at( ... )
+ *
+ * Draw a filled circle at [x, y] of radius 'r'.
+ */
+void
+gfx_fill_circle_at(GFX_CTX *g, int x, int y, int r, GFX_COLOR color) {
+	if (r <= 0) {
+		return;
+	}
+	__paint_quadrant(g, x, y, r, 0xf, 1, color);
+	g->cx = x; g->cy = y;
+}
+
+/*
+ * Anti-aliased lines and circles, after Xiaolin Wu. Each step along
+ * the major axis the true edge falls between two pixels and they
+ * split the color between them by how close it passes to each. The
+ * position of the edge is kept in integers (16.16 fixed point for a
+ * line, an incremental square root for a circle) so there is no
+ * floating point per pixel.
+ */
+
+/* blend a pixel of a line that may have had x and y swapped */
+static inline void
+__blend_xy(GFX_CTX *g, int steep, int a, int b, GFX_COLOR color, int cov)
+{
+	if (steep) {
+		__blend_pixel(g, b, a, color, cov);
+	} else {
+		__blend_pixel(g, a, b, color, cov);
+	}
+}
+
+/*
+ * gfx_draw_line_aa( ... )
+ *
+ * Draw an anti-aliased line from [x0, y0] to [x1, y1], see
+ * gfx_set_blend_func() for how the edge pixels are mixed in. The
+ * cursor is unchanged.
+ */
+void
+gfx_draw_line_aa(GFX_CTX *g, int x0, int y0, int x1, int y1, GFX_COLOR color)
+{
+	int		steep = abs(y1 - y0) > abs(x1 - x0);
+	int32_t	pos, step;
+	int		x, f;
+
+	if (steep) {
+		swap(x0, y0);
+		swap(x1, y1);
+	}
+	if (x0 > x1) {
+		swap(x0, x1);
+		swap(y0, y1);
+	}
+	/* the end points are on pixel centers */
+	__blend_xy(g, steep, x0, y0, color, 255);
+	if (x0 == x1) {
+		return;
+	}
+	__blend_xy(g, steep, x1, y1, color, 255);
+
+	step = (int32_t) (((int64_t) (y1 - y0) << 16) / (x1 - x0));
+	pos = ((int32_t) y0 << 16) + step;
+	for (x = x0 + 1; x < x1; x++) {
+		f = (pos >> 8) & 0xff;
+		__blend_xy(g, steep, x, pos >> 16, color, 255 - f);
+		__blend_xy(g, steep, x, (pos >> 16) + 1, color, f);
+		pos += step;
+	}
+}
+
+/*
+ * Blend the 8 way symmetric points [+/-a, +/-b] and [+/-b, +/-a]
+ * around [cx, cy], each of them once even when some of them land on
+ * the same pixel (on the axes and the diagonals).
+ */
+static void
+__blend_octants(GFX_CTX *g, int cx, int cy, int a, int b, GFX_COLOR color, int cov)
+{
+	int	i, p, q;
+
+	for (i = 0; i < 2; i++) {
+		p = (i) ? b : a;
+		q = (i) ? a : b;
+		if ((i == 1) && (a == b)) {
+			break;
+		}
+		__blend_pixel(g, cx + p, cy + q, color, cov);
+		if (q != 0) {
+			__blend_pixel(g, cx + p, cy - q, color, cov);
+		}
+		if (p != 0) {
+			__blend_pixel(g, cx - p, cy + q, color, cov);
+			if (q != 0) {
+				__blend_pixel(g, cx - p, cy - q, color, cov);
+			}
+		}
+	}
+}
+
+/*
+ * gfx_draw_circle_aa_at( ... )
+ *
+ * Draw an anti-aliased circle of radius 'r' centered at [x, y]. For
+ * each column of the first octant 'v' is r^2 - i^2 and j is the
+ * whole part of its square root (which only ever goes down), the
+ * fraction is close enough to (v - j^2) / (2j + 1). The cursor
+ * moves to [x, y].
+ */
+void
+gfx_draw_circle_aa_at(GFX_CTX *g, int x, int y, int r, GFX_COLOR color)
+{
+	int32_t	v, jj;
+	int		i, j, f;
+
+	g->cx = x; g->cy = y;
+	if (r <= 0) {
+		return;
+	}
+	v = jj = (int32_t) r * r;
+	j = r;
+	for (i = 0; ; i++) {
+		while (jj > v) {
+			jj -= 2 * j - 1;
+			j--;
+		}
+		f = ((v - jj) << 8) / (2 * j + 1);
+		if (i > j) {
+			/* stepped past the diagonal, just the pixel on it is left */
+			if (i == j + 1) {
+				__blend_octants(g, x, y, i, i, color, f);
+			}
+			break;
+		}
+		__blend_octants(g, x, y, i, j, color, 255 - f);
+		__blend_octants(g, x, y, i, j + 1, color, f);
+		v -= 2 * i + 1;
+	}
+}
+
+/*
+ * Ellipses, arcs and pie slices.
+ *
+ * The outline comes from the integer midpoint ellipse algorithm, it
+ * steps one quadrant and mirrors it. A fill is one span per row, the
+ * widest point the outline reaches on that row.
+ *
+ * Arcs and slices are limited by a wedge, the two edge directions
+ * are worked out once (the only trig) as fixed point vectors and a
+ * pixel is in the wedge if the cross products with both edges have
+ * the right sign. On a row the cross products are linear in x, so
+ * for fills the wedge turns into limits on the span rather than a
+ * test per pixel, and as the fill moves a row at a time those
+ * limits are stepped rather than divided out. Angles are in degrees
+ * counter-clockwise from 3 o'clock, as they would be on paper.
+ */
+#define WEDGE_ONE	16384
+
+/* one edge of a wedge as a limit on x, a * x >= m * dy + k */
+struct __halfline {
+	int		side;				/* 1 limits lo, -1 limits hi, 0 all or none */
+	struct __floor_step	t;		/* floor(-(m * dy + k) / |a|) */
+};
+
+struct __wedge {
+	int		all;				/* no limit, the whole ellipse */
+	int		reflex;				/* sweep is more than 180 degrees */
+	int64_t	sx, sy, ex, ey;		/* start and end directions (display) */
+	struct __halfline	edge[2][2];	/* fills, edges above and below center */
+};
+
+static void
+__wedge_init(struct __wedge *w, float start, float end)
+{
+#ifdef GFX_NO_FLOAT
+	/* same thing in 1/256ths of a degree off the sine table */
+	int32_t	s = (int32_t) (start * 256), e = (int32_t) (end * 256);
+	int32_t	sweep = (e - s) % (360 * 256);
+
+	sweep = (sweep <= 0) ? sweep + 360 * 256 : sweep;
+	w->all = (e - s >= 360 * 256) || (e - s <= -360 * 256);
+	w->reflex = (sweep > 180 * 256);
+	e = s + sweep;
+	w->sx = (__sin_fix(s + 90 * 256) + 2) >> 2;
+	w->sy = -((__sin_fix(s) + 2) >> 2);
+	w->ex = (__sin_fix(e + 90 * 256) + 2) >> 2;
+	w->ey = -((__sin_fix(e) + 2) >> 2);
+#else
+	float	sweep = fmodf(end - start, 360.0f);
+
+	sweep = (sweep <= 0) ? sweep + 360.0f : sweep;
+	w->all = (end - start >= 360.0f) || (end - start <= -360.0f);
+	w->reflex = (sweep > 180.0f);
+	start *= (float) M_PI / 180.0f;
+	end = start + sweep * (float) M_PI / 180.0f;
+	/* display Y is down so the sin is flipped */
+	w->sx = (int64_t) lroundf(cosf(start) * WEDGE_ONE);
+	w->sy = (int64_t) -lroundf(sinf(start) * WEDGE_ONE);
+	w->ex = (int64_t) lroundf(cosf(end) * WEDGE_ONE);
+	w->ey = (int64_t) -lroundf(sinf(end) * WEDGE_ONE);
+#endif
+}
+
+/* is the offset [dx, dy] from the center inside the wedge */
+static inline int
+__wedge_in(struct __wedge *w, int dx, int dy)
+{
+	if (w->all) {
+		return 1;
+	}
+	if (w->reflex) {
+		/* everything except the inside of the wedge from end to start */
+		return ! ((w->ex * dy - w->ey * dx < 0) && (dx * w->sy - dy * w->sx < 0));
+	}
+	return (w->sx * dy - w->sy * dx <= 0) && (dx * w->ey - dy * w->ex <= 0);
+}
+
+/* start an edge at row 'dy', moving 'step' (1 or -1) rows each time */
+static void
+__halfline_init(struct __halfline *h, int a, int m, int k, int dy, int step)
+{
+	h->side = (a > 0) - (a < 0);
+	__floor_step_init(&h->t, -(m * dy + k), -m * step, (a == 0) ? 1 : abs(a));
+}
+
+/* limit [lo, hi] to the x on this row where the edge holds, then step */
+static void
+__halfline(struct __halfline *h, int *lo, int *hi)
+{
+	int	t = h->t.q;
+
+	if (h->side > 0) {
+		t = -t;
+		*lo = (t > *lo) ? ((t > *hi + 1) ? *hi + 1 : t) : *lo;
+	} else if (h->side < 0) {
+		*hi = (t < *hi) ? ((t < *lo - 1) ? *lo - 1 : t) : *hi;
+	} else if (t < 0) {
+		*hi = *lo - 1;
+	}
+	__floor_step(&h->t);
+}
+
+/*
+ * Set up the wedge edges for a fill that starts with the rows 'b'
+ * above and below the center and works in to the center one row at
+ * a time. Non-reflex wedges keep x between the edges, reflex ones
+ * cut out the (strict) inside of the wedge from end to start.
+ */
+static void
+__wedge_rows(struct __wedge *w, int b)
+{
+	int	half, dy, step;
+
+	for (half = 0; half < 2; half++) {
+		dy = (half == 0) ? -b : b;
+		step = (half == 0) ? 1 : -1;
+		if (! w->reflex) {
+			__halfline_init(&w->edge[half][0], (int) w->sy, (int) w->sx, 0, dy, step);
+			__halfline_init(&w->edge[half][1], (int) -w->ey, (int) -w->ex, 0, dy, step);
+		} else {
+			__halfline_init(&w->edge[half][0], (int) w->ey, (int) w->ex, 1, dy, step);
+			__halfline_init(&w->edge[half][1], (int) -w->sy, (int) -w->sx, 1, dy, step);
+		}
+	}
+}
+
+/*
+ * paint row 'dy' of a fill, offsets -xr to xr, as limited by the
+ * wedge edges for that half of the ellipse
+ */
+static void
+__ellipse_row(GFX_CTX *g, int x0, int y0, int xr, int dy, struct __wedge *w,
+	struct __halfline *edge, GFX_COLOR color)
+{
+	int	lo = -xr, hi = xr, elo = -xr, ehi = xr;
+
+	if (w->all) {
+		__paint_span(g, x0 - xr, x0 + xr, y0 + dy, color);
+		return;
+	}
+	if (! w->reflex) {
+		__halfline(&edge[0], &lo, &hi);
+		__halfline(&edge[1], &lo, &hi);
+		if (lo <= hi) {
+			__paint_span(g, x0 + lo, x0 + hi, y0 + dy, color);
+		}
+		return;
+	}
+	__halfline(&edge[0], &elo, &ehi);
+	__halfline(&edge[1], &elo, &ehi);
+	if (elo > ehi) {
+		__paint_span(g, x0 + lo, x0 + hi, y0 + dy, color);
+		return;
+	}
+	if (elo > lo) {
+		__paint_span(g, x0 + lo, x0 + elo - 1, y0 + dy, color);
+	}
+	if (ehi < hi) {
+		__paint_span(g, x0 + ehi + 1, x0 + hi, y0 + dy, color);
+	}
+}
+
+/* one outline point and its mirror images */
+static void
+__ellipse_points(GFX_CTX *g, int x0, int y0, int x, int y, struct __wedge *w,
+	GFX_COLOR color)
+{
+	if (__wedge_in(w, x, -y)) {
+		__paint_pixel(g, x0 + x, y0 - y, color);
+	}
+	if ((x != 0) && __wedge_in(w, -x, -y)) {
+		__paint_pixel(g, x0 - x, y0 - y, color);
+	}
+	if (y != 0) {
+		if (__wedge_in(w, x, y)) {
+			__paint_pixel(g, x0 + x, y0 + y, color);
+		}
+		if ((x != 0) && __wedge_in(w, -x, y)) {
+			__paint_pixel(g, x0 - x, y0 + y, color);
+		}
+	}
+}
+
+/* a whole row of a fill is done, paint it above and below the center */
+static void
+__ellipse_fill_row(GFX_CTX *g, int x0, int y0, int x, int y, struct __wedge *w,
+	GFX_COLOR color)
+{
+	__ellipse_row(g, x0, y0, x, -y, w, w->edge[0], color);
+	if (y != 0) {
+		__ellipse_row(g, x0, y0, x, y, w, w->edge[1], color);
+	}
+}
+
+/*
+ * __paint_ellipse
+ *
+ * Midpoint ellipse with radii a (across) and b (down), the
+ * decision variables are kept at 4x so they stay integers. In the
+ * first region x steps every time, so a fill row is finished when
+ * y is about to step. In the second region y steps every time.
+ * Either way the fill rows come out one at a time from b in to
+ * the center, which is what lets __wedge_rows() step the limits.
+ */
+static void
+__paint_ellipse(GFX_CTX *g, int x0, int y0, int a, int b, int fill,
+	struct __wedge *w, GFX_COLOR color)
+{
+	int64_t	a2 = (int64_t) a * a, b2 = (int64_t) b * b;
+	int64_t	dx, dy, d;
+	int		x = 0, y = b;
+
+	if ((a < 0) || (b < 0)) {
+		return;
+	}
+	if (b == 0) {
+		/* flat, the steps below would never get across */
+		for (x = -a; x <= a; x++) {
+			if (__wedge_in(w, x, 0)) {
+				__paint_pixel(g, x0 + x, y0, color);
+			}
+		}
+		return;
+	}
+	if (fill && ! w->all) {
+		__wedge_rows(w, b);
+	}
+	dx = 0;
+	dy = 2 * a2 * y;
+	d = 4 * b2 - 4 * a2 * b + a2;
+	while (dx < dy) {
+		if (! fill) {
+			__ellipse_points(g, x0, y0, x, y, w, color);
+		}
+		if (d < 0) {
+			x++;
+			dx += 2 * b2;
+			d += 4 * (dx + b2);
+		} else {
+			if (fill) {
+				__ellipse_fill_row(g, x0, y0, x, y, w, color);
+			}
+			x++;
+			y--;
+			dx += 2 * b2;
+			dy -= 2 * a2;
+			d += 4 * (dx - dy + b2);
+		}
+	}
+	d = b2 * (4 * (int64_t) x * x + 4 * x + 1) + 4 * a2 * ((int64_t) (y - 1) * (y - 1)) -
+		4 * a2 * b2;
+	while (y >= 0) {
+		if (fill) {
+			__ellipse_fill_row(g, x0, y0, x, y, w, color);
+		} else {
+			__ellipse_points(g, x0, y0, x, y, w, color);
+		}
+		if (d > 0) {
+			y--;
+			dy -= 2 * a2;
+			d += 4 * (a2 - dy);
+		} else {
+			y--;
+			x++;
+			dx += 2 * b2;
+			dy -= 2 * a2;
+			d += 4 * (dx - dy + a2);
+		}
+	}
+}
+
+/*
+ * Where the ray at 'angle' leaves the ellipse, for the straight
+ * edges of a pie slice.
+ */
+static void
+__ellipse_edge(int x0, int y0, int a, int b, float angle, int *x, int *y)
+{
+#ifdef GFX_NO_FLOAT
+	int32_t	t = (int32_t) (angle * 256);
+	int64_t	c = __sin_fix(t + 90 * 256), s = __sin_fix(t), r;
+
+	/* c and s are 16.16, so the squares are 32.32 and r is 16.16 */
+	r = (int64_t) __isqrt64((b * c) * (b * c) + (a * s) * (a * s));
+	r = (r == 0) ? 0 : ((int64_t) a * b << 32) / r;
+	*x = x0 + (int) ((r * c + ((int64_t) 1 << 31)) >> 32);
+	*y = y0 - (int) ((r * s + ((int64_t) 1 << 31)) >> 32);
+#else
+	float	c = cosf(angle * (float) M_PI / 180.0f);
+	float	s = sinf(angle * (float) M_PI / 180.0f);
+	float	r = (float) a * b / sqrtf((b * c) * (b * c) + (a * s) * (a * s));
+
+	*x = x0 + (int) lroundf(r * c);
+	*y = y0 - (int) lroundf(r * s);
+#endif
+}
+
+/*
+ * gfx_draw_ellipse( ... )
+ *
+ * Draw an ellipse at the current location, 'rx' pixels from the
+ * center to the sides and 'ry' to the top and bottom.
+ */
+void
+gfx_draw_ellipse(GFX_CTX *g, int rx, int ry, GFX_COLOR color)
+{
+	struct __wedge	w = { .all = 1 };
+
+	__paint_ellipse(g, g->cx, g->cy, rx, ry, 0, &w, color);
+}
+
+/*
+ * gfx_draw_ellipse_at( ... )
+ *
+ * Draw an ellipse centered on [x, y].
+ */
+void
+gfx_draw_ellipse_at(GFX_CTX *g, int x, int y, int rx, int ry, GFX_COLOR color)
+{
+	struct __wedge	w = { .all = 1 };
+
+	__paint_ellipse(g, x, y, rx, ry, 0, &w, color);
+	g->cx = x; g->cy = y;
+}
+
+/*
+ * gfx_fill_ellipse( ... )
+ *
+ * Draw a filled ellipse at the current location.
+ */
+void
+gfx_fill_ellipse(GFX_CTX *g, int rx, int ry, GFX_COLOR color)
+{
+	struct __wedge	w = { .all = 1 };
+
+	__paint_ellipse(g, g->cx, g->cy, rx, ry, 1, &w, color);
+}
+
+/*
+ * gfx_fill_ellipse_at( ... )
+ *
+ * Draw a filled ellipse centered on [x, y].
+ */
+void
+gfx_fill_ellipse_at(GFX_CTX *g, int x, int y, int rx, int ry, GFX_COLOR color)
+{
+	struct __wedge	w = { .all = 1 };
+
+	__paint_ellipse(g, x, y, rx, ry, 1, &w, color);
+	g->cx = x; g->cy = y;
+}
+
+/*
+ * gfx_draw_arc_at( ... )
+ *
+ * Draw the part of the ellipse centered on [x, y] from angle 'start'
+ * counter-clockwise to angle 'end' (degrees, 0 is 3 o'clock). Use the
+ * same radius for both for a circular arc.
+ */
+void
+gfx_draw_arc_at(GFX_CTX *g, int x, int y, int rx, int ry, float start, float end,
+	GFX_COLOR color)
+{
+	struct __wedge	w;
+
+	__wedge_init(&w, start, end);
+	__paint_ellipse(g, x, y, rx, ry, 0, &w, color);
+	g->cx = x; g->cy = y;
+}
+
+/*
+ * gfx_draw_pie_at( ... )
+ *
+ * Outline of a pie slice, the arc from 'start' to 'end' and the two
+ * straight edges back to the center.
+ */
+void
+gfx_draw_pie_at(GFX_CTX *g, int x, int y, int rx, int ry, float start, float end,
+	GFX_COLOR color)
+{
+	struct __wedge	w;
+	int				ex, ey;
+
+	__wedge_init(&w, start, end);
+	__paint_ellipse(g, x, y, rx, ry, 0, &w, color);
+	if (! w.all) {
+		__ellipse_edge(x, y, rx, ry, start, &ex, &ey);
+		__paint_line(g, x, y, ex, ey, color);
+		__ellipse_edge(x, y, rx, ry, end, &ex, &ey);
+		__paint_line(g, x, y, ex, ey, color);
 	}
-	__paint_quadrant(g, g->cx, g->cy, r, 0xf, 1, color);
+	g->cx = x; g->cy = y;
 }
 
 /*
- * gfx_fill_circle_at( ... )
+ * gfx_fill_pie_at( ... )
  *
- * Draw a filled circle at [x, y] of radius 'r'.
+ * Filled pie slice from 'start' to 'end', one span (two if the slice
+ * is more than half of the ellipse) per row.
  */
 void
-gfx_fill_circle_at(GFX_CTX *g, int x, int y, int r, GFX_COLOR color) {
-	if (r <= 0) {
-		return;
-	}
-	__paint_quadrant(g, x, y, r, 0xf, 1, color);
+gfx_fill_pie_at(GFX_CTX *g, int x, int y, int rx, int ry, float start, float end,
+	GFX_COLOR color)
+{
+	struct __wedge	w;
+
+	__wedge_init(&w, start, end);
+	__paint_ellipse(g, x, y, rx, ry, 1, &w, color);
 	g->cx = x; g->cy = y;
 }
 
@@ -758,6 +2603,345 @@ gfx_fill_triangle_abs(GFX_CTX *g, int x0, int y0,
 						x2, y2,  color);
 }
 
+/*
+ * gfx_fill_polygon( ... )
+ *
+ * Fill the polygon with 'n' vertices given as x, y pairs in 'pts'
+ * in one scanline pass. The fill rule is even-odd unless the
+ * GFX_FILL_NONZERO flag is set. Convex polygons can have any number
+ * of vertices, others at most GFX_POLY_MAX. Returns -1 (and draws
+ * nothing) if there are too many. The cursor is unchanged.
+ */
+int
+gfx_fill_polygon(GFX_CTX *g, const int *pts, int n, GFX_COLOR color)
+{
+	return __paint_polygon(g, pts, n, color);
+}
+
+/*
+ * gfx_draw_polyline( ... )
+ *
+ * Draw connected lines through the 'n' points in 'pts' (x, y
+ * pairs). It isn't closed, repeat the first point at the end to
+ * outline a polygon. The cursor is unchanged.
+ */
+void
+gfx_draw_polyline(GFX_CTX *g, const int *pts, int n, GFX_COLOR color)
+{
+	int i;
+
+	if (n == 1) {
+		__paint_pixel(g, pts[0], pts[1], color);
+	}
+	for (i = 1; i < n; i++) {
+		__paint_line(g, pts[i * 2 - 2], pts[i * 2 - 1],
+						pts[i * 2], pts[i * 2 + 1], color);
+	}
+}
+
+/*
+ * Thick lines. A stroke is cut into convex pieces, a quad for each
+ * segment, a piece that fills the outside of each corner and the
+ * caps, and each piece is filled a span per scanline. The corners
+ * are kept as GFX_REALs so diagonals come out the right width. Pixel
+ * centers are on the integers and a pixel is painted if its center
+ * is inside the piece, with the same top-left rule as the other
+ * filled shapes.
+ */
+
+/* miters longer than this many times the width are bevelled */
+#define MITER_LIMIT	4
+
+/*
+ * __paint_convex_f
+ *
+ * Fill the convex polygon with 'n' GFX_REAL vertices in 'p'. With
+ * only a handful of edges it is quicker to look at all of them on
+ * each row than to walk the left and right chains.
+ */
+static void
+__paint_convex_f(GFX_CTX *g, const GFX_REAL *p, int n, GFX_COLOR color)
+{
+	GFX_REAL	ymin = p[1], ymax = p[1], xl, xr, x;
+	int		i, j, y, y1;
+
+	for (i = 1; i < n; i++) {
+		ymin = (p[i * 2 + 1] < ymin) ? p[i * 2 + 1] : ymin;
+		ymax = (p[i * 2 + 1] > ymax) ? p[i * 2 + 1] : ymax;
+	}
+	y = RCEIL(ymin);
+	y1 = RCEIL(ymax);
+	if (UNROTATED(g)) {
+		y = (y < 0) ? 0 : y;
+		y1 = (y1 > g->h) ? g->h : y1;
+	}
+	for (; y < y1; y++) {
+		xl = REAL_BIG;
+		xr = -REAL_BIG;
+		for (i = 0; i < n; i++) {
+			j = (i + 1 < n) ? i + 1 : 0;
+			/* the edge's top row is on it, its bottom row isn't */
+			if ((p[i * 2 + 1] <= GFX_REAL_INT(y)) == (p[j * 2 + 1] <= GFX_REAL_INT(y))) {
+				continue;
+			}
+			x = p[i * 2] + RMULDIV(GFX_REAL_INT(y) - p[i * 2 + 1],
+				p[j * 2] - p[i * 2], p[j * 2 + 1] - p[i * 2 + 1]);
+			xl = (x < xl) ? x : xl;
+			xr = (x > xr) ? x : xr;
+		}
+		if (RCEIL(xl) < RCEIL(xr)) {
+			__paint_span(g, RCEIL(xl), RCEIL(xr) - 1, y, color);
+		}
+	}
+}
+
+/*
+ * __paint_disc_f
+ *
+ * Fill a circle of radius r centered on [cx, cy], for round caps
+ * and joins.
+ */
+static void
+__paint_disc_f(GFX_CTX *g, GFX_REAL cx, GFX_REAL cy, GFX_REAL r, GFX_COLOR color)
+{
+	GFX_REAL	d;
+	int			y, y1, x0, x1;
+#ifdef GFX_NO_FLOAT
+	int64_t		d2;
+#endif
+
+	y = RCEIL(cy - r);
+	y1 = RCEIL(cy + r);
+	if (UNROTATED(g)) {
+		y = (y < 0) ? 0 : y;
+		y1 = (y1 > g->h) ? g->h : y1;
+	}
+	for (; y < y1; y++) {
+#ifdef GFX_NO_FLOAT
+		/* the squares are 32.32 */
+		d2 = (int64_t) r * r - (int64_t) (GFX_REAL_INT(y) - cy) * (GFX_REAL_INT(y) - cy);
+		if (d2 <= 0) {
+			continue;
+		}
+		d = (GFX_REAL) __isqrt64(d2);
+#else
+		d = r * r - (y - cy) * (y - cy);
+		if (d <= 0) {
+			continue;
+		}
+		d = sqrtf(d);
+#endif
+		x0 = RCEIL(cx - d);
+		x1 = RCEIL(cx + d) - 1;
+		if (x0 <= x1) {
+			__paint_span(g, x0, x1, y, color);
+		}
+	}
+}
+
+/*
+ * Paint the outside of the corner at [px, py] where a stroke of
+ * half width 'hw' going in direction d0 turns to direction d1 (both
+ * unit vectors). The inside of the corner is already covered by the
+ * two segments.
+ */
+static void
+__paint_join(GFX_CTX *g, GFX_REAL px, GFX_REAL py, GFX_REAL d0x, GFX_REAL d0y,
+	GFX_REAL d1x, GFX_REAL d1y, GFX_REAL hw, int join, GFX_COLOR color)
+{
+	GFX_REAL	cross = RMUL(d0x, d1y) - RMUL(d0y, d1x);
+	GFX_REAL	dot = RMUL(d0x, d1x) + RMUL(d0y, d1y);
+	GFX_REAL	s, k, p[8];
+
+	if (join == GFX_JOIN_ROUND) {
+		__paint_disc_f(g, px, py, hw, color);
+		return;
+	}
+	if (cross == 0) {
+		return;		/* straight on */
+	}
+	/* the outside is on the side the stroke turns away from */
+	s = (cross > 0) ? -hw : hw;
+	p[0] = px;
+	p[1] = py;
+	p[2] = px - RMUL(d0y, s);
+	p[3] = py + RMUL(d0x, s);
+	if ((join == GFX_JOIN_MITER) &&
+		((GFX_REAL_ONE + dot) * (MITER_LIMIT * MITER_LIMIT) >= GFX_REAL_INT(2))) {
+		k = RDIV(s, GFX_REAL_ONE + dot);
+		p[4] = px - RMUL(d0y + d1y, k);
+		p[5] = py + RMUL(d0x + d1x, k);
+		p[6] = px - RMUL(d1y, s);
+		p[7] = py + RMUL(d1x, s);
+		__paint_convex_f(g, p, 4, color);
+	} else {
+		p[4] = px - RMUL(d1y, s);
+		p[5] = py + RMUL(d1x, s);
+		__paint_convex_f(g, p, 3, color);
+	}
+}
+
+/*
+ * Paint the segment from [x0, y0] to [x1, y1] with half width hw.
+ * Square caps are done by stretching the quad out past the ends that
+ * have one ('caps' bit 0 is the start, bit 1 the end).
+ */
+static void
+__paint_segment_f(GFX_CTX *g, GFX_REAL x0, GFX_REAL y0, GFX_REAL x1, GFX_REAL y1,
+	GFX_REAL dx, GFX_REAL dy, GFX_REAL hw, int caps, GFX_COLOR color)
+{
+	GFX_REAL	p[8];
+
+	if (caps & 1) {
+		x0 -= RMUL(dx, hw);
+		y0 -= RMUL(dy, hw);
+	}
+	if (caps & 2) {
+		x1 += RMUL(dx, hw);
+		y1 += RMUL(dy, hw);
+	}
+	p[0] = x0 - RMUL(dy, hw);
+	p[1] = y0 + RMUL(dx, hw);
+	p[2] = x1 - RMUL(dy, hw);
+	p[3] = y1 + RMUL(dx, hw);
+	p[4] = x1 + RMUL(dy, hw);
+	p[5] = y1 - RMUL(dx, hw);
+	p[6] = x0 + RMUL(dy, hw);
+	p[7] = y0 - RMUL(dx, hw);
+	__paint_convex_f(g, p, 4, color);
+}
+
+/*
+ * gfx_set_line_style( ... )
+ *
+ * Set how the ends (GFX_CAP_xxx) and corners (GFX_JOIN_xxx) of
+ * lines wider than a pixel are drawn. The default is butt ends and
+ * mitered corners.
+ */
+void
+gfx_set_line_style(GFX_CTX *g, int cap, int join)
+{
+	g->cap = cap;
+	g->join = join;
+}
+
+/*
+ * gfx_draw_polyline_width( ... )
+ *
+ * Draw connected lines 'width' pixels wide through the 'n' points in
+ * 'pts' (x, y pairs), with the ends and corners set by
+ * gfx_set_line_style(). If the last point is the first one again the
+ * outline is closed and gets a corner there instead of two ends. A
+ * width of 1 or less is the same as gfx_draw_polyline(). The cursor
+ * is unchanged.
+ */
+void
+gfx_draw_polyline_width(GFX_CTX *g, const int *pts, int n, int width, GFX_COLOR color)
+{
+	GFX_REAL	hw = GFX_REAL_INT(width) / 2;
+	GFX_REAL	dx, dy, len, pdx = 0, pdy = 0, fdx = 0, fdy = 0;
+	int		i, prev, end, closed, caps;
+
+	if (width <= 1) {
+		gfx_draw_polyline(g, pts, n, color);
+		return;
+	}
+	if (n < 1) {
+		return;
+	}
+	/* the last point that isn't a repeat of the one before it */
+	for (end = n - 1; end > 0; end--) {
+		if ((pts[end * 2] != pts[end * 2 - 2]) ||
+			(pts[end * 2 + 1] != pts[end * 2 - 1])) {
+			break;
+		}
+	}
+	if (end == 0) {
+		/* just a dot, which only has ends */
+		if (g->cap == GFX_CAP_ROUND) {
+			__paint_disc_f(g, GFX_REAL_INT(pts[0]), GFX_REAL_INT(pts[1]), hw, color);
+		} else if (g->cap == GFX_CAP_SQUARE) {
+			__paint_segment_f(g, GFX_REAL_INT(pts[0]), GFX_REAL_INT(pts[1]),
+				GFX_REAL_INT(pts[0]), GFX_REAL_INT(pts[1]), GFX_REAL_ONE, 0, hw, 3, color);
+		}
+		return;
+	}
+	closed = (pts[end * 2] == pts[0]) && (pts[end * 2 + 1] == pts[1]);
+
+	for (prev = 0, i = 1; i <= end; i++) {
+		dx = GFX_REAL_INT(pts[i * 2] - pts[prev * 2]);
+		dy = GFX_REAL_INT(pts[i * 2 + 1] - pts[prev * 2 + 1]);
+		if ((dx == 0) && (dy == 0)) {
+			continue;
+		}
+		len = RHYPOT(dx, dy);
+		dx = RDIV(dx, len);
+		dy = RDIV(dy, len);
+		caps = 0;
+		if (prev == 0) {
+			fdx = dx;
+			fdy = dy;
+			caps |= (closed) ? 0 : 1;
+		} else {
+			__paint_join(g, GFX_REAL_INT(pts[prev * 2]), GFX_REAL_INT(pts[prev * 2 + 1]),
+				pdx, pdy, dx, dy, hw, g->join, color);
+		}
+		if (i == end) {
+			if (closed) {
+				__paint_join(g, GFX_REAL_INT(pts[0]), GFX_REAL_INT(pts[1]), dx, dy,
+					fdx, fdy, hw, g->join, color);
+			} else {
+				caps |= 2;
+			}
+		}
+		__paint_segment_f(g, GFX_REAL_INT(pts[prev * 2]), GFX_REAL_INT(pts[prev * 2 + 1]),
+			GFX_REAL_INT(pts[i * 2]), GFX_REAL_INT(pts[i * 2 + 1]), dx, dy, hw,
+			(g->cap == GFX_CAP_SQUARE) ? caps : 0, color);
+		if ((g->cap == GFX_CAP_ROUND) && (caps & 1)) {
+			__paint_disc_f(g, GFX_REAL_INT(pts[0]), GFX_REAL_INT(pts[1]), hw, color);
+		}
+		if ((g->cap == GFX_CAP_ROUND) && (caps & 2)) {
+			__paint_disc_f(g, GFX_REAL_INT(pts[i * 2]), GFX_REAL_INT(pts[i * 2 + 1]), hw, color);
+		}
+		pdx = dx;
+		pdy = dy;
+		prev = i;
+	}
+}
+
+/*
+ * gfx_draw_line_width( ... )
+ *
+ * Draw a line 'width' pixels wide from [x0, y0] to [x1, y1]. The
+ * cursor is unchanged.
+ */
+void
+gfx_draw_line_width(GFX_CTX *g, int x0, int y0, int x1, int y1, int width, GFX_COLOR color)
+{
+	int	pts[4];
+
+	pts[0] = x0;
+	pts[1] = y0;
+	pts[2] = x1;
+	pts[3] = y1;
+	gfx_draw_polyline_width(g, pts, 2, width, color);
+}
+
+/*
+ * gfx_fill_triangles( ... )
+ *
+ * Fill a mesh of 'count' triangles. 'verts' is a list of x, y
+ * pairs and 'indices' has three vertex numbers per triangle.
+ * Edges shared by two triangles are set up once and their pixels
+ * are painted once. Triangles with no area are skipped. The cursor
+ * is unchanged.
+ */
+void
+gfx_fill_triangles(GFX_CTX *g, const int *verts, const int *indices, int count, GFX_COLOR color)
+{
+	__paint_mesh(g, verts, indices, count, color);
+}
+
 /*
  * gfx_draw_rectangle( ... )
  *
@@ -843,26 +3027,297 @@ gfx_fill_rectangle_at(GFX_CTX *g, int x, int y, int w, int h, GFX_COLOR c)
  *
  * Clear the screen to a particular color. 
  * TODO: Add optional call back to do this efficently.
+ * For bitmaps we write the pixels directly, or if lazy
+ * clearing is on, just mark all the tiles as pending.
+ * With a clip rectangle set only that part is cleared.
  */
 void
 gfx_fill_screen(GFX_CTX *g, GFX_COLOR color)
 {
-	float t[2][2];
-	memcpy(t, g->cr.xfrm, sizeof(t)); /* backup rotation transform */
-	g->cr.xfrm[0][0] = 1;
-	g->cr.xfrm[1][1] = 1;
-	g->cr.xfrm[0][1] = 0;
-	g->cr.xfrm[1][0] = 0;
+#ifndef GFX_NO_ROTATION
+	GFX_TRANSFORM t;
+#endif
+	GFX_BITMAP *bm;
+	int	x, y;
+
+	if ((g->flags & (GFX_LAZY_CLEAR | GFX_CLIP)) == GFX_LAZY_CLEAR) {
+		g->lazy_color = color;
+		memset(g->lazy, 0xff, GFX_LAZY_WORDS(g->w, g->h) * sizeof(uint32_t));
+		return;
+	}
+	if ((g->flags & (GFX_FB_BITMAP | GFX_CLIP)) == GFX_FB_BITMAP) {
+		bm = g->fb;
+		for (y = 0; y < g->h; y++) {
+			for (x = 0; x < g->w; x++) {
+				bm->pixels[y * bm->stride + x] = color;
+			}
+		}
+		return;
+	}
+#ifdef GFX_NO_ROTATION
+	__paint_rectangle(g, 0, 0, g->w, g->h, color);
+#else
+	t = g->cr; /* backup rotation transform */
+	__rotation(g->cr.xfrm, 0);
+	__check_plain(&g->cr);
 	__paint_rectangle(g, 0, 0, g->w, g->h, color);
-	memcpy(g->cr.xfrm, t, sizeof(t)); /* restore rotation transform */
+	g->cr = t; /* restore rotation transform */
+#endif
+}
+
+/*
+ * gfx_draw_bitmap( ... )
+ *
+ * Draw the w x h block of pixels at the top left of bitmap 'src'
+ * with its top left corner at [x, y]. Into an unrotated, unmirrored
+ * bitmap context this is a copy of each row, otherwise it goes a
+ * pixel at a time.
+ */
+void
+gfx_draw_bitmap(GFX_CTX *g, int x, int y, GFX_BITMAP *src, int w, int h)
+{
+	GFX_BITMAP	*bm;
+	int			i, j, sx = 0, sy = 0;
+	int			x0, y0, x1, y1;
+
+	if (! UNROTATED(g) || ((g->flags & GFX_FB_BITMAP) == 0) ||
+		(g->flags & GFX_DISPLAY_INVERT_X) || OOB_REPORTING(g)) {
+		for (j = 0; j < h; j++) {
+			for (i = 0; i < w; i++) {
+				__paint_pixel(g, x + i, y + j, src->pixels[j * src->stride + i]);
+			}
+		}
+		return;
+	}
+	x0 = 0; y0 = 0; x1 = g->w; y1 = g->h;
+	if (g->flags & GFX_CLIP) {
+		x0 = g->clip.x0; y0 = g->clip.y0;
+		x1 = g->clip.x1; y1 = g->clip.y1;
+	}
+	if (x < x0) { sx = x0 - x; w -= sx; x = x0; }
+	if (y < y0) { sy = y0 - y; h -= sy; y = y0; }
+	w = (x + w > x1) ? x1 - x : w;
+	h = (y + h > y1) ? y1 - y : h;
+	if ((w <= 0) || (h <= 0)) {
+		return;
+	}
+	if (g->flags & GFX_LAZY_CLEAR) {
+		__lazy_touch_rect(g, x, y, w, h);
+	}
+	bm = g->fb;
+	for (j = 0; j < h; j++) {
+		memcpy(bm->pixels + (y + j) * bm->stride + x,
+			   src->pixels + (sy + j) * src->stride + sx, w * sizeof(GFX_COLOR));
+	}
+}
+
+/*
+ * gfx_copy_rect( ... )
+ *
+ * Move the w x h block of pixels at [x, y] by [dx, dy], for
+ * scrolling part of the screen. The source and destination
+ * may overlap. The block is clipped so that both ends of the
+ * move are on the screen. This needs a way to read pixels back
+ * so it works on GFX_BITMAP frame buffers or when a copy
+ * function has been set with gfx_set_copy_func(), and only
+ * when the display isn't rotated. Returns 0 if the pixels were
+ * moved and -1 if they could not be (the caller has to redraw).
+ */
+int
+gfx_copy_rect(GFX_CTX *g, int x, int y, int w, int h, int dx, int dy)
+{
+	GFX_BITMAP	*bm;
+	int			row;
+
+	if (! UNROTATED(g) ||
+		((g->copyrect == NULL) && ((g->flags & GFX_FB_BITMAP) == 0))) {
+		return -1;
+	}
+	/* clip the source, then clip again as the destination */
+	if (x < 0) { w += x; x = 0; }
+	if (y < 0) { h += y; y = 0; }
+	if (x + dx < 0) { w += x + dx; x -= x + dx; }
+	if (y + dy < 0) { h += y + dy; y -= y + dy; }
+	if (x + w > g->w) { w = g->w - x; }
+	if (y + h > g->h) { h = g->h - y; }
+	if (x + dx + w > g->w) { w = g->w - (x + dx); }
+	if (y + dy + h > g->h) { h = g->h - (y + dy); }
+	if ((w <= 0) || (h <= 0)) {
+		return 0;
+	}
+	if ((g->flags & GFX_DISPLAY_INVERT_X) != 0) {
+		x = g->w - (x + w);
+		dx = -dx;
+	}
+
+	/* both ends have to be real pixels, not tiles waiting to be cleared */
+	if (g->flags & GFX_LAZY_CLEAR) {
+		__lazy_touch_rect(g, x, y, w, h);
+		__lazy_touch_rect(g, x + dx, y + dy, w, h);
+	}
+
+	if (g->copyrect != NULL) {
+		(g->copyrect)(g->fb, x, y, w, h, dx, dy);
+		return 0;
+	}
+	bm = g->fb;
+	if (dy > 0) {
+		/* moving down, go bottom up so we don't copy a copy */
+		for (row = h - 1; row >= 0; row--) {
+			memmove(bm->pixels + (y + row + dy) * bm->stride + x + dx,
+					bm->pixels + (y + row) * bm->stride + x, w * sizeof(GFX_COLOR));
+		}
+	} else {
+		for (row = 0; row < h; row++) {
+			memmove(bm->pixels + (y + row + dy) * bm->stride + x + dx,
+					bm->pixels + (y + row) * bm->stride + x, w * sizeof(GFX_COLOR));
+		}
+	}
+	return 0;
+}
+
+/*
+ * Fade one row of pixels. Blue and red are done together (SWAR),
+ * they sit in the low byte of each 16 bit half of the pixel so there
+ * is a spare byte above each to catch the carry or borrow. Green is
+ * shifted down and done on its own, alpha is copied through as is.
+ */
+static void
+__fade_mul(GFX_COLOR *p, int n, uint32_t f)
+{
+	uint32_t	c;
+	int			i;
+
+	for (i = 0; i < n; i++) {
+		c = p[i].raw;
+		p[i].raw = ((((c & 0x00ff00ff) * f) >> 8) & 0x00ff00ff) |
+				   (((c >> 8) & 0xff) * f & 0xff00) | (c & 0xff000000);
+	}
+}
+
+static void
+__fade_sub(GFX_COLOR *p, int n, uint32_t s)
+{
+	const uint32_t	s2 = s * 0x00010001;
+	uint32_t		c, rb, gr, keep;
+	int				i;
+
+	for (i = 0; i < n; i++) {
+		c = p[i].raw;
+		/* borrow in from the guard bit, if it is still set there was room */
+		rb = ((c & 0x00ff00ff) | 0x01000100) - s2;
+		keep = ((rb & 0x01000100) >> 8) * 0xff;
+		rb &= keep;
+		gr = (((c >> 8) & 0xff) | 0x100) - s;
+		gr &= ((gr & 0x100) >> 8) * 0xff;
+		p[i].raw = rb | (gr << 8) | (c & 0xff000000);
+	}
+}
+
+/*
+ * gfx_fade_rect( ... )
+ *
+ * Fade the colors in the w x h block at [x, y] toward black, for
+ * persistence ("phosphor") displays. With GFX_FADE_SUB in flags
+ * 'amount' is taken off each channel, otherwise each channel is
+ * scaled by amount / 256. Like gfx_copy_rect() this has to read the
+ * pixels, so it only works on an unrotated GFX_BITMAP context and
+ * returns -1 if it can't fade them.
+ */
+int
+gfx_fade_rect(GFX_CTX *g, int x, int y, int w, int h, int amount, uint32_t flags)
+{
+	GFX_BITMAP	*bm;
+	int			x0, y0, x1, y1, row;
+
+	if (! UNROTATED(g) || ((g->flags & GFX_FB_BITMAP) == 0)) {
+		return -1;
+	}
+	__draw_box(g, &x0, &y0, &x1, &y1);
+	if (x < x0) { w -= x0 - x; x = x0; }
+	if (y < y0) { h -= y0 - y; y = y0; }
+	w = (x + w > x1) ? x1 - x : w;
+	h = (y + h > y1) ? y1 - y : h;
+	if ((w <= 0) || (h <= 0)) {
+		return 0;
+	}
+	if ((g->flags & GFX_DISPLAY_INVERT_X) != 0) {
+		x = g->w - (x + w);
+	}
+	if (g->flags & GFX_LAZY_CLEAR) {
+		__lazy_touch_rect(g, x, y, w, h);
+	}
+	amount = (amount < 0) ? 0 : amount;
+	bm = g->fb;
+	for (row = 0; row < h; row++) {
+		if (flags & GFX_FADE_SUB) {
+			__fade_sub(bm->pixels + (y + row) * bm->stride + x, w,
+				(amount > 255) ? 255 : amount);
+		} else {
+			__fade_mul(bm->pixels + (y + row) * bm->stride + x, w,
+				(amount > 256) ? 256 : amount);
+		}
+	}
+	return 0;
+}
+
+/* one row of a rounded rectangle, corners reach 'out' here and 'in' a row further out */
+static void
+__rounded_row(GFX_CTX *g, int xl, int xr, int row, int out, int in, int full,
+	GFX_COLOR color)
+{
+	if (full) {
+		__paint_span(g, xl - out, xr + out, row, color);
+	} else {
+		__paint_span(g, xl - out, xl - in, row, color);
+		__paint_span(g, xr + in, xr + out, row, color);
+	}
+}
+
+/*
+ * __paint_rounded_rect
+ *
+ * Paint a w x h rectangle at [x, y] with corners of radius r a row
+ * at a time. A filled row is one span and an outline row is at most
+ * two (the corners are 4-connected, so the pixels of a corner on a
+ * row run from where the next row out starts to where this one
+ * does), so no pixel is painted twice.
+ *
+ * On the row dy away from a corner's center the circle that
+ * __paint_quadrant() steps reaches out to the largest 'out' with
+ * out^2 + dy^2 <= r^2 + 1. Working in from the top and bottom rows
+ * together that only grows, so it is stepped along with an error
+ * term ('room' is how far (out + 1)^2 is from fitting) and nothing
+ * needs to be stored however big the radius is.
+ */
+static void
+__paint_rounded_rect(GFX_CTX *g, int x, int y, int w, int h, int r, int fill,
+	GFX_COLOR color)
+{
+	int	xl = x + r, xr = x + w - r - 1;	/* corner centers */
+	int	yt = y + r, yb = y + h - r - 1;
+	int	row, dy, in = 0, out = 0, room = 0;
+
+	for (dy = r; dy > 0; dy--) {
+		while (room >= 0) {
+			room -= 2 * out + 3;
+			out++;
+		}
+		__rounded_row(g, xl, xr, yt - dy, out, in, fill || (dy == r), color);
+		__rounded_row(g, xl, xr, yb + dy, out, in, fill || (dy == r), color);
+		in = out;
+		room += 2 * dy - 1;
+	}
+	/* the straight sides, the corners reach r out here */
+	for (row = yt; row <= yb; row++) {
+		__rounded_row(g, xl, xr, row, r, in, fill, color);
+	}
 }
 
 /*
  * gfx_draw_rounded_rectangle( ... )
  *
- * Draw a rectangle with rounded corners. Internally this provides
- * a good test if the quadrant drawing code and line drawing code
- * works together without gaps etc.
+ * Draw a rectangle with rounded corners.
  */
 
 void
@@ -876,17 +3331,7 @@ gfx_draw_rounded_rectangle(GFX_CTX *g, int w, int h, int r, GFX_COLOR color)
 	{
 		return; 
 	}
-
-	/* oddly formatted to be easier to read on wide screen */
-	__paint_quadrant(g, g->cx + r,       g->cy + r,       r, 4, 0, color); /* top left */
-	__paint_quadrant(g, g->cx + (w - r - 1), g->cy + r,       r, 8, 0, color); /* top right */
-	__paint_quadrant(g, g->cx + r,       g->cy + (h - r - 1), r, 2, 0, color); /* bottom left */
-	__paint_quadrant(g, g->cx + (w - r - 1), g->cy + (h - r - 1), r, 1, 0, color); /* bottom right */
-	/* oddly formatted to be easier to read on wide screen */
-	__paint_line(g, g->cx + r + 1, g->cy,         g->cx + (w - r - 2), g->cy,               color); /* top */
-	__paint_line(g, g->cx,         g->cy + r + 1, g->cx,               g->cy + (h - r - 2), color); /* left */
-	__paint_line(g, g->cx + w - 1, g->cy + r + 1, g->cx + w - 1,       g->cy + (h - r - 2), color); /* right */
-	__paint_line(g, g->cx + r + 1, g->cy + h - 1, g->cx + (w - r - 2), g->cy + h - 1,       color); /* bottom */
+	__paint_rounded_rect(g, g->cx, g->cy, w, h, r, 0, color);
 }
 
 void
@@ -899,8 +3344,7 @@ gfx_draw_rounded_rectangle_at(GFX_CTX *g, int x, int y, int w, int h, int r, GFX
 /*
  * gfx_fill_rounded_rectangle( ... )
  *
- * Draw a rectangle with rounded corners. Internally this provides
- * a good test if the filling code works together without gaps etc.
+ * Draw a filled rectangle with rounded corners, one span per row.
  */
 void
 gfx_fill_rounded_rectangle(GFX_CTX *g, int w, int h, int r, GFX_COLOR color)
@@ -913,43 +3357,7 @@ gfx_fill_rounded_rectangle(GFX_CTX *g, int w, int h, int r, GFX_COLOR color)
 	{
 		return; 
 	}
-
-	/* oddly formatted to be easier to read on wide screen */
-	__paint_quadrant(g, g->cx + r,       g->cy + r,       r, 4, 1, color);
-	__paint_quadrant(g, g->cx + (w - r - 1), g->cy + r,       r, 8, 1, color);
-	__paint_quadrant(g, g->cx + r,       g->cy + (h - r - 1), r, 2, 1, color);
-	__paint_quadrant(g, g->cx + (w - r - 1), g->cy + (h - r - 1), r, 1, 1, color);
-	/*
-	 * TODO Fix this to use paint_rectangle
-	 * Note: There are three 'internal' rectangles to be filled;
-	 *     - one is between the top and bottom left quadrants,
-	 *     - one is between all four quadrants,
-	 *     - and one is between thr top and bottom right quadrants.
-	 */
-	if ((h - 2 * r) > 0) {
-		__paint_triangle(g, g->cx,     g->cy + r,
-							g->cx + r, g->cy + r,
-							g->cx + r, g->cy + (h - r - 1), color);
-		__paint_triangle(g, g->cx,     g->cy + r,
-							g->cx,     g->cy + (h - r - 1),
-							g->cx + r, g->cy + (h - r - 1), color);
-		__paint_triangle(g, g->cx + (w - r - 1), g->cy + r,
-							g->cx + (w - 1),     g->cy + r,
-							g->cx + (w - 1),     g->cy + (h - r - 1), color);
-		__paint_triangle(g, g->cx + (w - r - 1), g->cy + r,
-							g->cx + (w - r - 1), g->cy + (h - r - 1),
-							g->cx + (w - 1),           g->cy + (h - r - 1), color);
-	}
-
-	if ((w - 2 * r) > 0) {
-		__paint_triangle(g, g->cx + r + 1,       g->cy,
-							g->cx + (w - r - 2), g->cy,
-							g->cx + (w - r - 2), g->cy + (h - 1), color);
-		__paint_triangle(g, g->cx + r + 1,       g->cy,
-							g->cx + r + 1,       g->cy + (h - 1),
-							g->cx + (w - r - 2), g->cy + (h - 1), color);
-	}
-
+	__paint_rounded_rect(g, g->cx, g->cy, w, h, r, 1, color);
 }
 
 void
@@ -959,6 +3367,7 @@ gfx_fill_rounded_rectangle_at(GFX_CTX *g, int x, int y, int w, int h, int r, GFX
 	gfx_fill_rounded_rectangle(g, w, h, r, color);
 }
 
+#ifndef GFX_NO_TEXT_ROTATION
 /*
  * gfx_set_text_rotation( ... )
  *
@@ -969,11 +3378,14 @@ gfx_fill_rounded_rectangle_at(GFX_CTX *g, int x, int y, int w, int h, int r, GFX
 void
 gfx_set_text_rotation(GFX_CTX *g, float angle)
 {
+#ifdef GFX_NO_FLOAT
+	g->text.cr.angle = (GFX_REAL) (angle * 65536.0f);
+#else
 	g->text.cr.angle = angle;
-	g->text.cr.xfrm[0][0] = g->text.cr.xfrm[1][1] = cos((angle * M_PI) / 180.0);
-	g->text.cr.xfrm[0][1] = -sin((angle * M_PI) / 180.0);
-	g->text.cr.xfrm[1][0] = - g->text.cr.xfrm[0][1];
+#endif
+	__rotation(g->text.cr.xfrm, angle);
 }
+#endif
 
 /*
  * gfx_set_text_cursor( ... )
@@ -1003,6 +3415,7 @@ gfx_set_text_color(GFX_CTX *g, GFX_COLOR fg, GFX_COLOR bg)
 	g->text.bg = bg;
 }
 
+#ifndef GFX_NO_MAGNIFY
 /*
  * gfx_set_text_size( ... )
  *
@@ -1013,6 +3426,7 @@ gfx_set_text_size(GFX_CTX *g, int size)
 {
 	g->text.magnify = size;
 }
+#endif
 
 /*
  * gfx_get_text_height( ... )
@@ -1071,7 +3485,7 @@ gfx_get_string_width(GFX_CTX *g, char *str)
 	}
 	w = strlen(str);
 	/* fixed width fonts are *simple* remember that */
-	return w * g->text.magnify * g->glyphs->width;
+	return w * MAGNIFY(g) * g->glyphs->width;
 }
 
 /*
@@ -1092,14 +3506,24 @@ gfx_set_font(GFX_CTX *g, GFX_FONT font)
 	g->text.font = font;
 	/* Always set small by default */
 	switch (font) {
+#ifndef GFX_NO_FONT_TINY
 		case GFX_FONT_TINY:
 			g->glyphs = &tiny_font;
 			break;	
+#endif
+#ifndef GFX_NO_FONT_LARGE
 		case GFX_FONT_LARGE:
 			g->glyphs = &large_font;
 			break;
+#endif
 		default:
+#if ! defined(GFX_NO_FONT_SMALL)
 			g->glyphs = &small_font;
+#elif ! defined(GFX_NO_FONT_LARGE)
+			g->glyphs = &large_font;
+#else
+			g->glyphs = &tiny_font;
+#endif
 			break;
 	}
 	return old;
@@ -1117,16 +3541,16 @@ __paint_glyph(GFX_CTX *g, int x, int y, uint8_t c, GFX_COLOR fg, GFX_COLOR bg) {
 	const uint8_t	*glyph;
 	GFX_FONT_GLYPHS	*font;
 	int i, k;
-	int	tm = g->text.magnify; /* text magnify */
+	int	tm = MAGNIFY(g); /* text magnify */
 	uint8_t descender, bit;
 	int dx, dy, tx, ty;
 
-	if ((int) c  >  g->glyphs->chars) {
-		return; // no glyph for this character.
-	}
 	if (g->glyphs == NULL) {
 		return;
 	}
+	if ((int) c  >  g->glyphs->chars) {
+		return; // no glyph for this character.
+	}
 	font = g->glyphs;
 
 	glyph = font->raw + (font->size * c);
@@ -1139,8 +3563,13 @@ __paint_glyph(GFX_CTX *g, int x, int y, uint8_t c, GFX_COLOR fg, GFX_COLOR bg) {
 			dx *= tm;
 			dy *= tm;
 			/* apply text rotation */
-			tx = dx * g->text.cr.xfrm[0][0] + dy * g->text.cr.xfrm[1][0];
-			ty = dx * g->text.cr.xfrm[0][1] + dy * g->text.cr.xfrm[1][1];
+#ifdef GFX_NO_TEXT_ROTATION
+			tx = dx;
+			ty = dy;
+#else
+			tx = RDOT(dx, g->text.cr.xfrm[0][0], dy, g->text.cr.xfrm[1][0]);
+			ty = RDOT(dx, g->text.cr.xfrm[0][1], dy, g->text.cr.xfrm[1][1]);
+#endif
 			if (bit) {
 				if (tm > 1) {
 					__paint_triangle(g, x + tx, y + ty,
@@ -1206,8 +3635,12 @@ gfx_putc(GFX_CTX *g, char c)
 {
 	int tx, ty;
 	__paint_glyph(g, g->text.cx, g->text.cy, c, g->text.fg, g->text.bg);
-	g->text.cx += g->glyphs->width * g->text.magnify * g->text.cr.xfrm[0][0];
-	g->text.cy += g->glyphs->width * g->text.magnify * g->text.cr.xfrm[0][1];
+#ifdef GFX_NO_TEXT_ROTATION
+	g->text.cx += g->glyphs->width * MAGNIFY(g);
+#else
+	g->text.cx += RMULI(g->glyphs->width * MAGNIFY(g), g->text.cr.xfrm[0][0]);
+	g->text.cy += RMULI(g->glyphs->width * MAGNIFY(g), g->text.cr.xfrm[0][1]);
+#endif
 }
 
 /*
@@ -19,8 +19,36 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h> /* for memset */
+#include <math.h>
 #include <gfx.h>
 
+#ifndef GFX_NO_VIEWPORT
+
+/*
+ * Multiply and divide GFX_REALs. In 16.16 fixed point the product
+ * is worked out in 64 bits and a quotient that won't fit is pinned
+ * at the biggest value there is.
+ */
+#ifdef GFX_NO_FLOAT
+#define RMUL(a, b)	((GFX_REAL) (((int64_t) (a) * (b)) / 65536))
+#define RDIV(a, b)	rdiv(a, b)
+
+static GFX_REAL
+rdiv(GFX_REAL a, GFX_REAL b)
+{
+	int64_t	q;
+
+	if (b == 0) {
+		return (a < 0) ? INT32_MIN : INT32_MAX;
+	}
+	q = ((int64_t) a * 65536) / b;
+	return (q > INT32_MAX) ? INT32_MAX : ((q < INT32_MIN) ? INT32_MIN : (GFX_REAL) q);
+}
+#else
+#define RMUL(a, b)	((a) * (b))
+#define RDIV(a, b)	((a) / (b))
+#endif
+
 /*
  * return a value between the minimum and maximum value
  */
@@ -40,13 +68,18 @@ minmax(int minimum, int a, int maximum)
  *
  * Create a transform that will scale between floating
  * point (x,y) co-ordinates into a region on the display
- * screen.
+ * screen. Pass constants as GFX_REAL_INT(1) or
+ * GFX_REAL_CONST(0.5) so they also work without floats.
  */
 GFX_VIEW *
 gfx_viewport(GFX_VIEW *vprt, GFX_CTX *g, int x, int y, int w, int h, 
-	float min_x, float min_y, float max_x, float max_y)
+	GFX_REAL min_x, GFX_REAL min_y, GFX_REAL max_x, GFX_REAL max_y)
 {
-	GFX_VIEW *res = (vprt == NULL) ? malloc(sizeof(GFX_VIEW)) : vprt;
+	GFX_VIEW *res = (vprt == NULL) ? gfx_alloc(sizeof(GFX_VIEW)) : vprt;
+
+	if (res == NULL) {
+		return NULL;
+	}
 	memset(res, 0, sizeof(GFX_VIEW));
 	res->g = g;
 	res->x = x;
@@ -59,31 +92,1008 @@ gfx_viewport(GFX_VIEW *vprt, GFX_CTX *g, int x, int y, int w, int h,
 }
 
 static void
-transform(GFX_VIEW *v, float x_in, float y_in, int *x_out, int *y_out)
+transform(GFX_VIEW *v, GFX_REAL x_in, GFX_REAL y_in, int *x_out, int *y_out)
 {
-	x_in = (x_in - v->min_x) * v->sx + v->x;
+	x_in = RMUL(x_in - v->ax, v->sx) + GFX_REAL_INT(v->x + v->ox);
 	/* flip Y co-ordinate "+y is up in viewport, down in display" */
-	y_in = (v->h + v->y) - ((y_in - v->min_y) * v->sy);
-	*x_out = minmax(v->x, x_in, v->x + v->w);
-	*y_out = minmax(v->y, y_in, v->y + v->h);
+	y_in = GFX_REAL_INT(v->h + v->y + v->oy) - RMUL(y_in - v->ay, v->sy);
+	*x_out = minmax(v->x, GFX_REAL_TO_INT(x_in), v->x + v->w);
+	*y_out = minmax(v->y, GFX_REAL_TO_INT(y_in), v->y + v->h);
+}
+
+/*
+ * Viewport co-ordinates to display co-ordinates, but left as floats
+ * and not clamped, ready to be clipped.
+ */
+static void
+transform_f(GFX_VIEW *v, GFX_REAL x_in, GFX_REAL y_in, GFX_REAL *x_out, GFX_REAL *y_out)
+{
+	*x_out = RMUL(x_in - v->ax, v->sx) + GFX_REAL_INT(v->x + v->ox);
+	/* flip Y co-ordinate "+y is up in viewport, down in display" */
+	*y_out = GFX_REAL_INT(v->h + v->y + v->oy) - RMUL(y_in - v->ay, v->sy);
+}
+
+/*
+ * Liang-Barsky clip of the segment [x0, y0] - [x1, y1] to the box
+ * [bx0, by0] - [bx1, by1]. The viewport transform just scales and
+ * moves each axis, so clipping the transformed floats to the
+ * viewport's box on the display is the same as clipping in viewport
+ * space, and saves transforming the cut points. Ends that are inside
+ * are left exactly as they were. Returns 0 if none of the segment is
+ * in the box.
+ */
+static int
+clip_line(GFX_REAL bx0, GFX_REAL by0, GFX_REAL bx1, GFX_REAL by1,
+	GFX_REAL *x0, GFX_REAL *y0, GFX_REAL *x1, GFX_REAL *y1)
+{
+	GFX_REAL	dx = *x1 - *x0, dy = *y1 - *y0;
+	GFX_REAL	p[4], q[4], r, t0 = 0, t1 = GFX_REAL_ONE;
+	int		k;
+
+#ifndef GFX_NO_FLOAT
+	if ((dx != dx) || (dy != dy)) {
+		return 0;	/* NaN somewhere */
+	}
+#endif
+	p[0] = -dx; q[0] = *x0 - bx0;
+	p[1] = dx;  q[1] = bx1 - *x0;
+	p[2] = -dy; q[2] = *y0 - by0;
+	p[3] = dy;  q[3] = by1 - *y0;
+	for (k = 0; k < 4; k++) {
+		if (p[k] == 0) {
+			/* parallel to this edge, all in or all out */
+			if (q[k] < 0) {
+				return 0;
+			}
+			continue;
+		}
+		r = RDIV(q[k], p[k]);
+		if (p[k] < 0) {
+			if (r > t1) {
+				return 0;
+			}
+			t0 = (r > t0) ? r : t0;
+		} else {
+			if (r < t0) {
+				return 0;
+			}
+			t1 = (r < t1) ? r : t1;
+		}
+	}
+	/* cut, and keep rounding from putting the cut just outside */
+	if (t1 < GFX_REAL_ONE) {
+		*x1 = *x0 + RMUL(t1, dx);
+		*y1 = *y0 + RMUL(t1, dy);
+		*x1 = (*x1 < bx0) ? bx0 : ((*x1 > bx1) ? bx1 : *x1);
+		*y1 = (*y1 < by0) ? by0 : ((*y1 > by1) ? by1 : *y1);
+	}
+	if (t0 > 0) {
+		*x0 = *x0 + RMUL(t0, dx);
+		*y0 = *y0 + RMUL(t0, dy);
+		*x0 = (*x0 < bx0) ? bx0 : ((*x0 > bx1) ? bx1 : *x0);
+		*y0 = (*y0 < by0) ? by0 : ((*y0 > by1) ? by1 : *y0);
+	}
+	return 1;
+}
+
+/* clip to the viewport's box on the display */
+#define CLIP_VIEW(v, x0, y0, x1, y1) \
+	clip_line(GFX_REAL_INT((v)->x), GFX_REAL_INT((v)->y), GFX_REAL_INT((v)->x + (v)->w), \
+		GFX_REAL_INT((v)->y + (v)->h), x0, y0, x1, y1)
+
+#ifndef GFX_NO_FLOAT
+/*
+ * Draw the display space segment [x0, y0] - [x1, y1], clipped
+ * to the viewport.
+ */
+static void
+plot_clipped(GFX_VIEW *v, float x0, float y0, float x1, float y1, GFX_COLOR c)
+{
+	if (CLIP_VIEW(v, &x0, &y0, &x1, &y1)) {
+		gfx_draw_line_abs(v->g, (int) x0, (int) y0, (int) x1, (int) y1, c);
+	}
+}
+#endif
+
+/*
+ * vp_transform( ... )
+ *
+ * Work out where the viewport point [x, y] is on the display. Returns
+ * 1 if it is inside the viewport, 0 if it isn't (and the pixel is
+ * clamped to the edge of the viewport).
+ */
+int
+vp_transform(GFX_VIEW *v, GFX_REAL x, GFX_REAL y, int *px, int *py)
+{
+	GFX_REAL	fx, fy;
+
+	transform_f(v, x, y, &fx, &fy);
+	transform(v, x, y, px, py);
+	return ((fx >= GFX_REAL_INT(v->x)) && (fx <= GFX_REAL_INT(v->x + v->w)) &&
+			(fy >= GFX_REAL_INT(v->y)) && (fy <= GFX_REAL_INT(v->y + v->h)));
 }
 
 /*
  * vp_plot( ... )
  *
  * Draw a line from [x0, y0] to [x1, y1] in the viewport space, which
- * is transformed into a line draw in display space.
+ * is transformed into a line draw in display space. The line is
+ * clipped to the viewport, if none of it is in the viewport nothing
+ * is drawn (and the cursor isn't moved).
+ */
+void
+vp_plot(GFX_VIEW *v, GFX_REAL x0, GFX_REAL y0, GFX_REAL x1, GFX_REAL y1, GFX_COLOR c)
+{
+	GFX_REAL	fx0, fy0, fx1, fy1;
+
+	transform_f(v, x0, y0, &fx0, &fy0);
+	transform_f(v, x1, y1, &fx1, &fy1);
+	if (! CLIP_VIEW(v, &fx0, &fy0, &fx1, &fy1)) {
+		return;
+	}
+	gfx_move_to(v->g, GFX_REAL_TO_INT(fx0), GFX_REAL_TO_INT(fy0));
+	gfx_draw_line_to(v->g, GFX_REAL_TO_INT(fx1), GFX_REAL_TO_INT(fy1), c);
+}
+
+#ifndef GFX_NO_FLOAT
+/* points transformed per pass by the series plotting code */
+#define VP_CHUNK	128
+
+/* outcode bits, which side(s) of a box a point is off */
+#define VP_LEFT		0x01
+#define VP_RIGHT	0x02
+#define VP_TOP		0x04
+#define VP_BOTTOM	0x08
+#define VP_NOPOINT	0x10	/* sample was NaN, breaks the line */
+
+/*
+ * The part of the display a segment has to reach to be worth drawing.
+ * Normally that is the viewport, but if the context has a clip
+ * rectangle (vp_pan sets one while it redraws a band) and isn't
+ * rotated it is only where the two overlap. Segments are still cut
+ * at the viewport, this only decides which segments get skipped.
+ */
+static void
+cull_box(GFX_VIEW *v, float *x0, float *y0, float *x1, float *y1)
+{
+	GFX_CTX *g = v->g;
+
+	*x0 = v->x;
+	*y0 = v->y;
+	*x1 = v->x + v->w;
+	*y1 = v->y + v->h;
+	if ((g->flags & GFX_CLIP) && g->cr.plain) {
+		*x0 = (g->clip.x0 > *x0) ? g->clip.x0 : *x0;
+		*y0 = (g->clip.y0 > *y0) ? g->clip.y0 : *y0;
+		*x1 = (g->clip.x1 < *x1) ? g->clip.x1 : *x1;
+		*y1 = (g->clip.y1 < *y1) ? g->clip.y1 : *y1;
+	}
+}
+
+/*
+ * Transform 'n' points into display co-ordinates in one pass. This
+ * is the same arithmetic as transform_f() so a series comes out
+ * exactly as it would with vp_plot, but it is a straight run over the
+ * arrays with no calls and no branches the compiler can't turn into
+ * selects, so it will vectorize where the target has SIMD. Along with
+ * each point it returns an outcode saying which sides of the viewport
+ * the point is off, and one for the cull box.
+ */
+static void
+transform_n(GFX_VIEW *v, const float *xs, int xst, const float *ys, int yst,
+	int n, float *x_out, float *y_out, uint8_t *code, uint8_t *cull)
+{
+	const float	x0 = v->x, x1 = v->x + v->w;
+	const float	y0 = v->y, y1 = v->y + v->h;
+	const float	xa = v->x + v->ox, yb = v->h + v->y + v->oy;
+	float		fx, fy, cx0, cy0, cx1, cy1;
+	int			i;
+
+	cull_box(v, &cx0, &cy0, &cx1, &cy1);
+	for (i = 0; i < n; i++) {
+		fx = (xs[i * xst] - v->ax) * v->sx + xa;
+		/* flip Y co-ordinate "+y is up in viewport, down in display" */
+		fy = yb - ((ys[i * yst] - v->ay) * v->sy);
+		code[i] = (fx < x0) | ((fx > x1) << 1) | ((fy < y0) << 2) | ((fy > y1) << 3);
+		cull[i] = (fx < cx0) | ((fx > cx1) << 1) | ((fy < cy0) << 2) | ((fy > cy1) << 3);
+		if ((fx != fx) || (fy != fy)) {
+			code[i] = cull[i] = VP_NOPOINT;
+		}
+		x_out[i] = fx;
+		y_out[i] = fy;
+	}
+}
+
+/*
+ * vp_plot_points( ... )
+ *
+ * Plot 'n' unconnected points (a scatter plot). The points are
+ * transformed a chunk at a time, the ones outside the viewport are
+ * dropped and the rest are drawn with one gfx_draw_points() call.
+ * Each point is the pixel vp_plot() would draw for it.
  */
 void
-vp_plot(GFX_VIEW *v, float x0, float y0, float x1, float y1, GFX_COLOR c)
+vp_plot_points(GFX_VIEW *v, const float *xs, const float *ys, int n, GFX_COLOR c)
 {
-	int	x, y;
+	float	px[VP_CHUNK], py[VP_CHUNK];
+	uint8_t	code[VP_CHUNK], cull[VP_CHUNK];
+	int		xy[2 * VP_CHUNK];
+	int		i, k, m, out;
 
-	transform(v, x0, y0, &x, &y);
-	gfx_move_to(v->g, x, y);
+	for (i = 0; i < n; i += VP_CHUNK) {
+		m = ((n - i) < VP_CHUNK) ? n - i : VP_CHUNK;
+		transform_n(v, xs + i, 1, ys + i, 1, m, px, py, code, cull);
+		for (k = 0, out = 0; k < m; k++) {
+			if (cull[k] == 0) {
+				xy[out++] = (int) px[k];
+				xy[out++] = (int) py[k];
+			}
+		}
+		gfx_draw_points(v->g, xy, out / 2, c);
+	}
+}
 
-	transform(v, x1, y1, &x, &y);
-	gfx_draw_line_to(v->g, x, y, c);
+/*
+ * vp_plot_segments( ... )
+ *
+ * Plot 'n' separate line segments (a vector field, error bars, ...),
+ * 'xy' holds x0, y0, x1, y1 for each of them. Both ends of a chunk of
+ * segments are transformed in one pass, only segments that cross the
+ * edge of the viewport are clipped, and what is left is drawn with one
+ * gfx_draw_segments() call. Each segment comes out exactly as vp_plot()
+ * would draw it.
+ */
+void
+vp_plot_segments(GFX_VIEW *v, const float *xy, int n, GFX_COLOR c)
+{
+	float	px[VP_CHUNK], py[VP_CHUNK];
+	uint8_t	code[VP_CHUNK], cull[VP_CHUNK];
+	int		seg[2 * VP_CHUNK];
+	float	x0, y0, x1, y1;
+	int		i, k, m, out;
+
+	for (i = 0; i < n; i += VP_CHUNK / 2) {
+		m = ((n - i) < VP_CHUNK / 2) ? n - i : VP_CHUNK / 2;
+		/* the ends are just x, y pairs two floats apart */
+		transform_n(v, xy + 4 * i, 2, xy + 4 * i + 1, 2, 2 * m, px, py, code, cull);
+		for (k = 0, out = 0; k < 2 * m; k += 2) {
+			if (cull[k] & cull[k + 1]) {
+				continue;
+			}
+			x0 = px[k]; y0 = py[k];
+			x1 = px[k + 1]; y1 = py[k + 1];
+			if ((code[k] | code[k + 1]) && ! CLIP_VIEW(v, &x0, &y0, &x1, &y1)) {
+				continue;
+			}
+			seg[out++] = (int) x0;
+			seg[out++] = (int) y0;
+			seg[out++] = (int) x1;
+			seg[out++] = (int) y1;
+		}
+		gfx_draw_segments(v->g, seg, out / 4, c);
+	}
+}
+
+/*
+ * Column decimation. When there are many more samples than pixel
+ * columns almost every segment starts and ends in the same column,
+ * and the pixels those segments cover are just the run from the
+ * lowest to the highest sample in the column. So rather than drawing
+ * them we keep one open vertical span, grow it while segments stay in
+ * its column and overlap or touch it, and only draw it when that
+ * stops. Segments that change column (the connectors from the last
+ * sample of one column to the first of the next) are drawn as is.
+ * The pixels covered are exactly the pixels the full plot covers,
+ * but for data that advances in X there are at most a span and a
+ * connector per column no matter how many samples there are.
+ */
+static void
+column_flush(GFX_SERIES *s)
+{
+	if (s->open) {
+		gfx_draw_line_abs(s->vp->g, s->cx, s->lo, s->cx, s->hi, s->color);
+		s->open = 0;
+	}
+}
+
+static void
+column_segment(GFX_SERIES *s, int x0, int y0, int x1, int y1)
+{
+	int	lo, hi;
+
+	if (x0 != x1) {
+		gfx_draw_line_abs(s->vp->g, x0, y0, x1, y1, s->color);
+		return;
+	}
+	lo = (y0 < y1) ? y0 : y1;
+	hi = (y0 < y1) ? y1 : y0;
+	if (s->open && (s->cx == x0) && (lo <= s->hi + 1) && (hi >= s->lo - 1)) {
+		s->lo = (lo < s->lo) ? lo : s->lo;
+		s->hi = (hi > s->hi) ? hi : s->hi;
+		return;
+	}
+	column_flush(s);
+	s->open = 1;
+	s->cx = x0;
+	s->lo = lo;
+	s->hi = hi;
+}
+
+/*
+ * vp_series_begin( ... )
+ *
+ * Start plotting a series in color 'c' that will be handed over a
+ * piece at a time. The pieces are joined up as if they had all been
+ * passed in one array.
+ */
+void
+vp_series_begin(GFX_SERIES *s, GFX_VIEW *v, GFX_COLOR c)
+{
+	memset(s, 0, sizeof(GFX_SERIES));
+	s->vp = v;
+	s->color = c;
+	s->lcode = s->lcull = VP_NOPOINT;
+}
+
+/*
+ * vp_series_add( ... )
+ *
+ * Add 'n' points to the series. The X values are every 'xstride'
+ * floats starting at xs, and the Y values every 'ystride' floats
+ * starting at ys. Each point is transformed once. Segments that are
+ * entirely off one side of the viewport are skipped without any more
+ * work, ones that cross its edge are clipped, and runs of visible
+ * segments are drawn as polylines. A NaN in either array leaves a gap
+ * in the line. If the viewport is in decimate mode the segments are
+ * fed through the column decimator instead.
+ */
+void
+vp_series_add(GFX_SERIES *s, const float *xs, int xstride, const float *ys,
+	int ystride, int n)
+{
+	GFX_VIEW	*v = s->vp;
+	float	px[VP_CHUNK], py[VP_CHUNK];
+	uint8_t	code[VP_CHUNK], cull[VP_CHUNK];
+	int		pts[(VP_CHUNK + 1) * 2];
+	int		base, m, i, np = 0;
+	int		decimate = (v->flags & VP_DECIMATE) != 0;
+	float	ax, ay, bx, by;
+
+	for (base = 0; base < n; base += VP_CHUNK) {
+		m = ((n - base) < VP_CHUNK) ? (n - base) : VP_CHUNK;
+		transform_n(v, xs + base * xstride, xstride, ys + base * ystride, ystride,
+			m, px, py, code, cull);
+		for (i = 0; i < m; i++) {
+			ax = s->lx; ay = s->ly;
+			bx = px[i]; by = py[i];
+			if ((((code[i] | s->lcode) & VP_NOPOINT) != 0) ||
+				((cull[i] & s->lcull) != 0) ||
+				(((code[i] | s->lcode) != 0) && ! CLIP_VIEW(v, &ax, &ay, &bx, &by))) {
+				/* none of this segment shows */
+				if (np > 0) {
+					gfx_draw_polyline(v->g, pts, np, s->color);
+					np = 0;
+				}
+			} else if (decimate) {
+				column_segment(s, (int) ax, (int) ay, (int) bx, (int) by);
+			} else {
+				/* a run restarts where a segment comes back into view */
+				if ((np > 0) && (s->lcode != 0)) {
+					gfx_draw_polyline(v->g, pts, np, s->color);
+					np = 0;
+				}
+				if (np == 0) {
+					pts[0] = (int) ax;
+					pts[1] = (int) ay;
+					np = 1;
+				}
+				pts[np * 2] = (int) bx;
+				pts[np * 2 + 1] = (int) by;
+				np++;
+			}
+			s->lx = px[i];
+			s->ly = py[i];
+			s->lcode = code[i];
+			s->lcull = cull[i];
+		}
+		/* the next chunk picks up from the last point */
+		if (np > 0) {
+			gfx_draw_polyline(v->g, pts, np, s->color);
+			np = 0;
+		}
+	}
+}
+
+/* size in bytes of each sample type */
+static const int sample_size[] = { 4, 2, 2, 1, 1, 4 };
+
+/*
+ * Convert 'n' raw samples starting at 'p' into floats, scaled and
+ * offset by the descriptor. One loop per type so the inner loops
+ * stay simple.
+ */
+#define CONVERT(type) \
+	for (i = 0; i < n; i++, p += stride) { \
+		out[i] = *(const type *) p * d->scale + d->offset; \
+	}
+
+static void
+convert_n(const GFX_SAMPLES *d, const uint8_t *p, int stride, int n, float *out)
+{
+	int	i;
+
+	switch (d->type) {
+		case GFX_SAMPLE_F32:
+			CONVERT(float);
+			break;
+		case GFX_SAMPLE_I16:
+			CONVERT(int16_t);
+			break;
+		case GFX_SAMPLE_U16:
+			CONVERT(uint16_t);
+			break;
+		case GFX_SAMPLE_I8:
+			CONVERT(int8_t);
+			break;
+		case GFX_SAMPLE_U8:
+			CONVERT(uint8_t);
+			break;
+		case GFX_SAMPLE_I32:
+			CONVERT(int32_t);
+			break;
+		default:
+			for (i = 0; i < n; i++) {
+				out[i] = NAN;
+			}
+			break;
+	}
+}
+
+/*
+ * vp_series_samples( ... )
+ *
+ * Add 'n' raw samples to the series straight out of a buffer (say a
+ * memory mapped capture file, or one window of it). The descriptor
+ * says what the samples are and where the channel we want lives in
+ * each frame. 'first' is the index of the first sample in the whole
+ * stream and is only used to work out X (x0 + index * dx, done in
+ * double so long captures don't lose their place). The samples are
+ * converted VP_CHUNK at a time on the stack, nothing is copied or
+ * allocated no matter how big the buffer is.
+ */
+void
+vp_series_samples(GFX_SERIES *s, const GFX_SAMPLES *d, const void *data,
+	long first, long n)
+{
+	float	xs[VP_CHUNK], ys[VP_CHUNK];
+	const uint8_t *p;
+	int		size, stride, m, i;
+	long	base;
+
+	if (((unsigned) d->type) >= (sizeof(sample_size) / sizeof(int))) {
+		return;
+	}
+	size = sample_size[d->type];
+	stride = (d->stride > 0) ? d->stride : size * ((d->channels > 0) ? d->channels : 1);
+	p = (const uint8_t *) data + d->channel * size;
+	for (base = 0; base < n; base += VP_CHUNK) {
+		m = ((n - base) < VP_CHUNK) ? (n - base) : VP_CHUNK;
+		for (i = 0; i < m; i++) {
+			xs[i] = (float) (d->x0 + (double) (first + base + i) * d->dx);
+		}
+		convert_n(d, p + base * stride, stride, m, ys);
+		vp_series_add(s, xs, 1, ys, 1, m);
+	}
+}
+
+/*
+ * vp_series_end( ... )
+ *
+ * Finish off a series, draws anything still pending.
+ */
+void
+vp_series_end(GFX_SERIES *s)
+{
+	column_flush(s);
+}
+
+/*
+ * vp_plot_series_strided( ... )
+ *
+ * Plot a connected series of 'n' points. The X values are every
+ * 'xstride' floats starting at xs, and the Y values every 'ystride'
+ * floats starting at ys, so interleaved x, y data is just
+ * (xy, 2, xy + 1, 2).
+ */
+void
+vp_plot_series_strided(GFX_VIEW *v, const float *xs, int xstride,
+	const float *ys, int ystride, int n, GFX_COLOR c)
+{
+	GFX_SERIES	s;
+
+	vp_series_begin(&s, v, c);
+	vp_series_add(&s, xs, xstride, ys, ystride, n);
+	vp_series_end(&s);
+}
+
+/*
+ * vp_plot_series( ... )
+ *
+ * Plot a connected series of 'n' points from separate X and Y arrays.
+ */
+void
+vp_plot_series(GFX_VIEW *v, const float *xs, const float *ys, int n, GFX_COLOR c)
+{
+	vp_plot_series_strided(v, xs, 1, ys, 1, n, c);
+}
+
+/*
+ * vp_plot_samples( ... )
+ *
+ * Plot 'n' raw samples described by 'd' as one connected series.
+ */
+void
+vp_plot_samples(GFX_VIEW *v, const GFX_SAMPLES *d, const void *data, long n,
+	GFX_COLOR c)
+{
+	GFX_SERIES	s;
+
+	vp_series_begin(&s, v, c);
+	vp_series_samples(&s, d, data, 0, n);
+	vp_series_end(&s);
+}
+
+/*
+ * Strip charts. A strip chart is a trace that scrolls to the left as
+ * samples arrive, the newest sample is always in the rightmost column
+ * of the viewport and each sample is 'step' pixels after the one
+ * before it. Instead of redrawing the whole trace for each sample the
+ * chart area is moved over by 'step' pixels with gfx_copy_rect() and
+ * only the new columns are drawn. The last samples are kept in a ring
+ * so the chart can still be redrawn from scratch when it has to be
+ * (after a rescale, or if the display can't move pixels around).
+ */
+
+/* display column of the sample 'age' samples before the newest */
+#define STRIP_X(s, age)	((s)->vp->x + (s)->vp->w - 1 - (age) * (s)->step)
+
+/* display row of sample value y */
+static int
+strip_y(GFX_STRIP *s, float y)
+{
+	int	x_out, y_out;
+
+	transform(s->vp, s->vp->min_x, y, &x_out, &y_out);
+	return y_out;
+}
+
+/* sample 'age' samples before the newest */
+#define STRIP_SAMPLE(s, age)	\
+	((s)->ring[((s)->head - 1 - (age) + (s)->size) % (s)->size])
+
+/*
+ * vp_strip_init( ... )
+ *
+ * Set up a strip chart in the viewport that moves 'step' pixels per
+ * sample and draws in fg on bg. The ring holds the samples for the
+ * visible part of the chart, if ring is NULL one is allocated. A ring
+ * of 'n' samples shows at most n - 1 segments, a ring that is bigger
+ * than the viewport can show is only used up to what it can show.
+ */
+GFX_STRIP *
+vp_strip_init(GFX_STRIP *s, GFX_VIEW *v, int step, float *ring, int n,
+	GFX_COLOR fg, GFX_COLOR bg)
+{
+	GFX_STRIP	*res;
+	int			need;
+
+	if ((step < 1) || (step >= v->w)) {
+		return NULL;
+	}
+	need = (v->w - 1) / step + 1;
+	res = (s == NULL) ? gfx_alloc(sizeof(GFX_STRIP)) : s;
+	if (res == NULL) {
+		return NULL;
+	}
+	memset(res, 0, sizeof(GFX_STRIP));
+	if (ring == NULL) {
+		n = need;
+		ring = gfx_alloc(n * sizeof(float));
+		if (ring == NULL) {
+			if (s == NULL) {
+				gfx_free(res);
+			}
+			return NULL;
+		}
+	}
+	res->vp = v;
+	res->ring = ring;
+	res->size = (n < need) ? n : need;
+	res->step = step;
+	res->fg = fg;
+	res->bg = bg;
+	return res;
+}
+
+/*
+ * vp_strip_redraw( ... )
+ *
+ * Clear the chart and draw it again from the samples in the ring.
+ */
+void
+vp_strip_redraw(GFX_STRIP *s)
+{
+	GFX_VIEW	*v = s->vp;
+	int			age;
+
+	gfx_fill_rectangle_at(v->g, v->x, v->y, v->w, v->h + 1, s->bg);
+	if (s->count == 1) {
+		gfx_draw_point_at(v->g, STRIP_X(s, 0), strip_y(s, STRIP_SAMPLE(s, 0)), s->fg);
+	}
+	for (age = s->count - 1; age > 0; age--) {
+		gfx_draw_line_abs(v->g, STRIP_X(s, age), strip_y(s, STRIP_SAMPLE(s, age)),
+			STRIP_X(s, age - 1), strip_y(s, STRIP_SAMPLE(s, age - 1)), s->fg);
+	}
+}
+
+/*
+ * vp_strip_add( ... )
+ *
+ * Add a sample to the chart. The chart is scrolled 'step' pixels and
+ * only the columns that scroll in are drawn. When the oldest sample
+ * drops out of the ring the part of the trace that led up to it is
+ * erased too, so the chart always looks just like vp_strip_redraw()
+ * would draw it. If the pixels can't be moved the whole chart is
+ * redrawn instead.
+ */
+void
+vp_strip_add(GFX_STRIP *s, float y)
+{
+	GFX_VIEW	*v = s->vp;
+	int			dropped, old_x;
+
+	dropped = (s->count == s->size);
+	s->ring[s->head] = y;
+	s->head = (s->head + 1) % s->size;
+	if (! dropped) {
+		s->count++;
+	}
+	if (s->count == 1) {
+		vp_strip_redraw(s);
+		return;
+	}
+	if (gfx_copy_rect(v->g, v->x + s->step, v->y, v->w - s->step, v->h + 1,
+					  -s->step, 0) != 0) {
+		vp_strip_redraw(s);
+		return;
+	}
+	/* the new columns on the right */
+	gfx_fill_rectangle_at(v->g, STRIP_X(s, 0) - s->step + 1, v->y, s->step,
+		v->h + 1, s->bg);
+	gfx_draw_line_abs(v->g, STRIP_X(s, 1), strip_y(s, STRIP_SAMPLE(s, 1)),
+		STRIP_X(s, 0), strip_y(s, STRIP_SAMPLE(s, 0)), s->fg);
+	if (dropped) {
+		/* whatever is left of the oldest sample goes, then its segment again */
+		old_x = STRIP_X(s, s->count - 1);
+		gfx_fill_rectangle_at(v->g, v->x, v->y, (old_x - v->x) + 1, v->h + 1, s->bg);
+		gfx_draw_line_abs(v->g, old_x, strip_y(s, STRIP_SAMPLE(s, s->count - 1)),
+			STRIP_X(s, s->count - 2), strip_y(s, STRIP_SAMPLE(s, s->count - 2)), s->fg);
+	}
+}
+#endif /* GFX_NO_FLOAT */
+
+/*
+ * Panning and zooming. A pan moves the pixels that are already on
+ * the screen and then only the bands that scrolled into view are
+ * drawn again. The library doesn't know what is plotted in the view
+ * so it calls the view's redraw function for each band with the
+ * context clipped to it. The series and M4 plotting functions skip
+ * everything outside the clip, so a redraw function can just plot
+ * all of its data and only the band costs anything.
+ */
+
+/*
+ * vp_set_redraw( ... )
+ *
+ * Set the function that redraws the rectangle [x, y, w, h] of the
+ * view after a pan or zoom. It should clear the rectangle and plot
+ * into it, the context is already clipped to it.
+ */
+void
+vp_set_redraw(GFX_VIEW *v, void (*redraw)(GFX_VIEW *, int, int, int, int, void *),
+	void *arg)
+{
+	v->redraw = redraw;
+	v->redraw_arg = arg;
+}
+
+/*
+ * Redraw one rectangle of the view with the context clipped to it
+ * (and to any clip rectangle the caller already had set).
+ */
+static void
+redraw_rect(GFX_VIEW *v, int x, int y, int w, int h)
+{
+	GFX_CTX	*g = v->g;
+	int		x0, y0, x1, y1;
+	int		had_clip = g->flags & GFX_CLIP;
+	int16_t	save[4];
+
+	if ((v->redraw == NULL) || (w <= 0) || (h <= 0)) {
+		return;
+	}
+	save[0] = g->clip.x0; save[1] = g->clip.y0;
+	save[2] = g->clip.x1; save[3] = g->clip.y1;
+	x0 = x; y0 = y; x1 = x + w; y1 = y + h;
+	if (had_clip) {
+		x0 = (save[0] > x0) ? save[0] : x0;
+		y0 = (save[1] > y0) ? save[1] : y0;
+		x1 = (save[2] < x1) ? save[2] : x1;
+		y1 = (save[3] < y1) ? save[3] : y1;
+		if ((x0 >= x1) || (y0 >= y1)) {
+			return;
+		}
+	}
+	gfx_set_clip(g, x0, y0, x1 - x0, y1 - y0);
+	(v->redraw)(v, x0, y0, x1 - x0, y1 - y0, v->redraw_arg);
+	g->clip.x0 = save[0]; g->clip.y0 = save[1];
+	g->clip.x1 = save[2]; g->clip.y1 = save[3];
+	if (! had_clip) {
+		gfx_clear(g, GFX_CLIP);
+	}
+}
+
+/*
+ * vp_pan( ... )
+ *
+ * Move the picture in the view 'dx' pixels right and 'dy' pixels
+ * down, so the view now shows data further left (and higher up).
+ * The scale doesn't change. The pixels already drawn are moved with
+ * gfx_copy_rect() and the redraw function is called for the strip
+ * down the side and the strip across the top or bottom that
+ * scrolled in. If the pixels can't be moved the whole view is
+ * redrawn.
+ */
+void
+vp_pan(GFX_VIEW *v, int dx, int dy)
+{
+	/* lines are clipped to x + w and y + h so the view is one bigger */
+	int	w = v->w + 1, h = v->h + 1;
+	int	adx = (dx < 0) ? -dx : dx;
+	int	ady = (dy < 0) ? -dy : dy;
+
+	if ((dx == 0) && (dy == 0)) {
+		return;
+	}
+	/*
+	 * The picture moves by whole pixels so points are moved exactly
+	 * as far as the pixels are, min and max are only kept up to date
+	 * to say what is in view.
+	 */
+	v->ox += dx;
+	v->oy += dy;
+	v->min_x -= RDIV(GFX_REAL_INT(dx), v->sx);
+	v->max_x -= RDIV(GFX_REAL_INT(dx), v->sx);
+	v->min_y += RDIV(GFX_REAL_INT(dy), v->sy);
+	v->max_y += RDIV(GFX_REAL_INT(dy), v->sy);
+	v->gen++;
+	/* move the part of the view that stays in the view */
+	if ((adx >= w) || (ady >= h) ||
+		(gfx_copy_rect(v->g, (dx > 0) ? v->x : v->x + adx, (dy > 0) ? v->y : v->y + ady,
+					   w - adx, h - ady, dx, dy) != 0)) {
+		redraw_rect(v, v->x, v->y, w, h);
+		return;
+	}
+	/*
+	 * Lines that ran off the edge were cut there, and a cut line isn't
+	 * always the same pixels as the whole line. So the bands take in one
+	 * row or column of what was moved, where the old cuts ended up, and
+	 * the edge the picture moved towards is redrawn so lines get cut
+	 * there now.
+	 */
+	adx += (adx != 0);
+	ady += (ady != 0);
+	/* the columns that came in, full height */
+	redraw_rect(v, (dx > 0) ? v->x : v->x + w - adx, v->y, adx, h);
+	/* and the rows, less the columns we just did */
+	redraw_rect(v, (dx > 0) ? v->x + adx : v->x, (dy > 0) ? v->y : v->y + h - ady,
+		w - adx, ady);
+	if (dx != 0) {
+		redraw_rect(v, (dx > 0) ? v->x + w - 1 : v->x, v->y, 1, h);
+	}
+	if (dy != 0) {
+		redraw_rect(v, v->x, (dy > 0) ? v->y + h - 1 : v->y, w, 1);
+	}
+}
+
+#ifndef GFX_NO_FLOAT
+/*
+ * vp_zoom( ... )
+ *
+ * Zoom the view by 'factor' (bigger than 1 zooms in) keeping the
+ * point [cx, cy] where it is on the screen, then redraw it. Nothing
+ * on the screen can be reused so this is where plotting from an M4
+ * cache pays off, it doesn't go back to the samples.
+ */
+void
+vp_zoom(GFX_VIEW *v, float factor, float cx, float cy)
+{
+	if (factor <= 0) {
+		return;
+	}
+	vp_rescale(v, cx + (v->min_x - cx) / factor, cy + (v->min_y - cy) / factor,
+				  cx + (v->max_x - cx) / factor, cy + (v->max_y - cy) / factor);
+	redraw_rect(v, v->x, v->y, v->w + 1, v->h + 1);
+}
+
+/*
+ * vp_m4_init( ... )
+ *
+ * Set up an M4 cache of 'n' bins, 'dx' wide, starting at X value
+ * 'x0'. If bins is NULL they are allocated. Make the bins at least
+ * as narrow as a pixel column at the most zoomed in view you want
+ * to draw from the cache, wider views just merge bins together.
+ */
+GFX_M4 *
+vp_m4_init(GFX_M4 *m, GFX_M4_BIN *bins, int n, double x0, double dx)
+{
+	GFX_M4	*res;
+	int		i;
+
+	if ((n <= 0) || (dx <= 0)) {
+		return NULL;
+	}
+	res = (m == NULL) ? gfx_alloc(sizeof(GFX_M4)) : m;
+	if (res == NULL) {
+		return NULL;
+	}
+	res->bins = (bins == NULL) ? gfx_alloc(n * sizeof(GFX_M4_BIN)) : bins;
+	if (res->bins == NULL) {
+		if (m == NULL) {
+			gfx_free(res);
+		}
+		return NULL;
+	}
+	res->x0 = x0;
+	res->dx = dx;
+	res->n = n;
+	for (i = 0; i < n; i++) {
+		res->bins[i].first = NAN;
+	}
+	return res;
+}
+
+/*
+ * vp_m4_add( ... )
+ *
+ * Put 'n' samples into the cache, in the order they should be
+ * joined up (normally increasing X). Samples outside the cache or
+ * with a NaN in them are ignored.
+ */
+void
+vp_m4_add(GFX_M4 *m, const float *xs, const float *ys, long n)
+{
+	GFX_M4_BIN	*b;
+	double		bin;
+	long		i;
+
+	for (i = 0; i < n; i++) {
+		bin = (xs[i] - m->x0) / m->dx;
+		if ((bin < 0) || (bin >= m->n) || (ys[i] != ys[i])) {
+			continue;
+		}
+		b = &m->bins[(int) bin];
+		if (b->first != b->first) {
+			b->first = b->last = b->min = b->max = ys[i];
+			continue;
+		}
+		b->last = ys[i];
+		b->min = (ys[i] < b->min) ? ys[i] : b->min;
+		b->max = (ys[i] > b->max) ? ys[i] : b->max;
+	}
+}
+
+/*
+ * vp_m4_plot( ... )
+ *
+ * Plot the cache into the view. Each bin is placed in the pixel
+ * column its left edge falls in, bins in the same column are merged,
+ * and every column gets a line from the smallest to the largest
+ * sample and a line joining it to the column before (last sample to
+ * first sample). Only the bins under the view (or the clip rectangle)
+ * are looked at, plus one either side so the lines into and out of
+ * the view are drawn.
+ */
+void
+vp_m4_plot(GFX_VIEW *v, GFX_M4 *m, GFX_COLOR c)
+{
+	GFX_M4_BIN	*b;
+	float		cx0, cy0, cx1, cy1, fx, fy, ly = 0, y0, y1;
+	double		xa, xb;
+	int			i, ia, ib, col = 0, have = 0, lx = 0, cur = 0;
+	float		first = 0, last = 0, lo = 0, hi = 0;
+
+	/* the X range we need, in bins */
+	cull_box(v, &cx0, &cy0, &cx1, &cy1);
+	xa = v->ax + (cx0 - v->x - v->ox) / v->sx;
+	xb = v->ax + (cx1 + 1 - v->x - v->ox) / v->sx;
+	ia = (int) floor((xa - m->x0) / m->dx) - 1;
+	ib = (int) floor((xb - m->x0) / m->dx) + 1;
+	ia = (ia < 0) ? 0 : ia;
+	ib = (ib >= m->n) ? m->n - 1 : ib;
+
+	for (i = ia; i <= ib + 1; i++) {
+		if (i <= ib) {
+			b = &m->bins[i];
+			if (b->first != b->first) {
+				continue;
+			}
+			transform_f(v, (float) (m->x0 + i * m->dx), 0, &fx, &fy);
+			col = (int) floor(fx);
+			if (have && (col == cur)) {
+				/* same column, merge it in */
+				last = b->last;
+				lo = (b->min < lo) ? b->min : lo;
+				hi = (b->max > hi) ? b->max : hi;
+				continue;
+			}
+		}
+		if (have) {
+			/* draw the column we've been building */
+			if (have > 1) {
+				transform_f(v, 0, first, &fx, &fy);
+				plot_clipped(v, lx, ly, cur, fy, c);
+			}
+			transform_f(v, 0, lo, &fx, &y0);
+			transform_f(v, 0, hi, &fx, &y1);
+			plot_clipped(v, cur, y0, cur, y1, c);
+			transform_f(v, 0, last, &fx, &ly);
+			lx = cur;
+		}
+		if (i > ib) {
+			break;
+		}
+		have = (have) ? 2 : 1;
+		cur = col;
+		first = b->first;
+		last = b->last;
+		lo = b->min;
+		hi = b->max;
+	}
+}
+#endif /* GFX_NO_FLOAT */
+
+/*
+ * vp_fade( ... )
+ *
+ * Fade everything in the viewport toward black (see gfx_fade_rect),
+ * call it once a frame before drawing the new trace and the old ones
+ * linger and die away like on an analog scope. Returns -1 if the
+ * context's pixels can't be read back, draw into a GFX_BITMAP and
+ * copy it to the display with gfx_draw_bitmap() in that case.
+ */
+int
+vp_fade(GFX_VIEW *v, int amount, uint32_t flags)
+{
+	return gfx_fade_rect(v->g, v->x, v->y, v->w + 1, v->h + 1, amount, flags);
+}
+
+/*
+ * vp_set_decimate( ... )
+ *
+ * Turn column decimation on (on != 0) or off for series plots
+ * in this viewport. The image is the same either way, decimation
+ * just draws it with far fewer calls when there are many samples
+ * per pixel column.
+ */
+void
+vp_set_decimate(GFX_VIEW *v, int on)
+{
+	if (on) {
+		v->flags |= VP_DECIMATE;
+	} else {
+		v->flags &= ~VP_DECIMATE;
+	}
 }
 
 /*
@@ -92,14 +1102,19 @@ vp_plot(GFX_VIEW *v, float x0, float y0, float x1, float y1, GFX_COLOR c)
  * Reset the scaling of the passed in viewport.
  */
 void
-vp_rescale(GFX_VIEW *v, float min_x, float min_y, float max_x, float max_y)
+vp_rescale(GFX_VIEW *v, GFX_REAL min_x, GFX_REAL min_y, GFX_REAL max_x, GFX_REAL max_y)
 {
 	/* Set scale for X and scale for Y */
-	v->sx = (float) v->w / (max_x - min_x);
-	v->sy = (float) v->h / (max_y - min_y);
+	v->sx = RDIV(GFX_REAL_INT(v->w), max_x - min_x);
+	v->sy = RDIV(GFX_REAL_INT(v->h), max_y - min_y);
 	/* Offsets to move pixels into a 0 - (n+m) space from a -n to +m space */
 	v->min_x = min_x;
 	v->min_y = min_y;
 	v->max_x = max_x;
 	v->max_y = max_y;
+	v->ax = min_x;
+	v->ay = min_y;
+	v->ox = v->oy = 0;
+	v->gen++;
 }
+#endif /* GFX_NO_VIEWPORT */
@@ -0,0 +1,119 @@
+/*
+ * waterfall.c -- Waterfall (spectrogram) displays
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * A waterfall shows a spectrum per line with the power in each bin
+ * as a color, the newest line at the top and the history flowing
+ * down the view. Everything but the new line is already on the
+ * display, so each update moves the old lines down one row with
+ * gfx_copy_rect() and draws only the new one, mapped to colors
+ * through a lookup table and written as a single row. If the display
+ * can't move pixels it "sweeps" instead, each line overwrites the
+ * oldest one and the newest line walks down the view, wrapping at
+ * the bottom.
+ */
+
+#include <stdint.h>
+#include <gfx.h>
+
+#ifndef GFX_NO_VIEWPORT
+#ifndef GFX_NO_FLOAT
+
+/* columns mapped per pass */
+#define WF_CHUNK	128
+
+/*
+ * vp_waterfall_init( ... )
+ *
+ * Set up a waterfall filling viewport 'vp'. Values from 'lo' to 'hi'
+ * are colored with the 'n' entry table 'lut'. 'row' has room for one
+ * line of the view (w + 1 colors), if it is NULL it is allocated.
+ * With VP_WATERFALL_SWEEP in flags the view is never moved, new lines
+ * overwrite the oldest one.
+ */
+GFX_WATERFALL *
+vp_waterfall_init(GFX_WATERFALL *wf, GFX_VIEW *vp, GFX_COLOR *row,
+	const GFX_COLOR *lut, int n, float lo, float hi, uint32_t flags)
+{
+	GFX_WATERFALL *res = (wf == NULL) ? gfx_alloc(sizeof(GFX_WATERFALL)) : wf;
+
+	if (res == NULL) {
+		return NULL;
+	}
+	res->row.pixels = (row == NULL) ? gfx_alloc((vp->w + 1) * sizeof(GFX_COLOR)) : row;
+	if (res->row.pixels == NULL) {
+		if (wf == NULL) {
+			gfx_free(res);
+		}
+		return NULL;
+	}
+	res->row.stride = vp->w + 1;
+	res->vp = vp;
+	res->lut = lut;
+	res->n = n;
+	res->lo = lo;
+	res->hi = hi;
+	res->flags = flags;
+	res->head = 0;
+	res->lines = 0;
+	return res;
+}
+
+/*
+ * vp_waterfall_add( ... )
+ *
+ * Add a spectrum of 'nbins' values as the newest line. If there are
+ * more bins than columns each column shows the largest of its bins
+ * (so narrow peaks don't vanish), if there are fewer the bins are
+ * stretched.
+ */
+void
+vp_waterfall_add(GFX_WATERFALL *wf, const float *bins, int nbins)
+{
+	GFX_VIEW	*v = wf->vp;
+	int			cols = v->w + 1, rows = v->h + 1;
+	float		col[WF_CHUNK], m;
+	int			x, k, b0, b1, len, y;
+
+	if (nbins <= 0) {
+		return;
+	}
+	/* make room for it, either scroll or overwrite the oldest line */
+	if (((wf->flags & VP_WATERFALL_SWEEP) == 0) &&
+		(gfx_copy_rect(v->g, v->x, v->y, cols, rows - 1, 0, 1) == 0)) {
+		y = v->y;
+	} else {
+		wf->flags |= VP_WATERFALL_SWEEP;
+		y = v->y + wf->head;
+		wf->head = (wf->head + 1) % rows;
+	}
+
+	for (x = 0; x < cols; x += WF_CHUNK) {
+		len = (cols - x < WF_CHUNK) ? cols - x : WF_CHUNK;
+		if (nbins == cols) {
+			gfx_colormap_map(wf->lut, wf->n, wf->lo, wf->hi, bins + x, len,
+				wf->row.pixels + x);
+			continue;
+		}
+		for (k = 0; k < len; k++) {
+			b0 = (int) (((long) (x + k) * nbins) / cols);
+			b1 = (int) (((long) (x + k + 1) * nbins) / cols);
+			for (m = bins[b0], b0++; b0 < b1; b0++) {
+				m = (bins[b0] > m) ? bins[b0] : m;
+			}
+			col[k] = m;
+		}
+		gfx_colormap_map(wf->lut, wf->n, wf->lo, wf->hi, col, len, wf->row.pixels + x);
+	}
+	gfx_draw_bitmap(v->g, v->x, y, &wf->row, cols, 1);
+	wf->lines++;
+}
+#endif /* GFX_NO_FLOAT */
+#endif /* GFX_NO_VIEWPORT */
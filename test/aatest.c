@@ -0,0 +1,117 @@
+/*
+ * Simple Graphics - anti-aliased line and circle test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Draws anti-aliased lines and circles with a blend function that
+ * keeps the coverage of each pixel, and prints the coverage as
+ * shades. Along a line (and around a circle) the coverage of the
+ * two pixels at each step should add up to a whole pixel. The same
+ * drawing into a GFX_BITMAP should blend to the same values.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+
+static int			cover[SWIDTH * SHEIGHT];
+static GFX_COLOR	pixels[SWIDTH * SHEIGHT];
+
+static void
+blend_pixel(void *fb, int x, int y, GFX_COLOR color, int alpha)
+{
+	cover[y * SWIDTH + x] += alpha;
+}
+
+static void
+print_cover(void)
+{
+	const char	*shades = " .:-=+*#%@";
+	int			x, y, c;
+
+	for (y = 0; y < SHEIGHT; y++) {
+		for (x = 0; x < SWIDTH; x++) {
+			c = cover[y * SWIDTH + x];
+			putchar(shades[(c >= 255) ? 9 : (c * 9 + 254) / 255]);
+		}
+		putchar('\n');
+	}
+}
+
+/* steps along x where the coverage in the column isn't one pixel */
+static int
+column_errors(int x0, int x1)
+{
+	int	x, y, sum, bad = 0;
+
+	for (x = x0; x <= x1; x++) {
+		for (sum = 0, y = 0; y < SHEIGHT; y++) {
+			sum += cover[y * SWIDTH + x];
+		}
+		bad += (sum != 255);
+	}
+	return bad;
+}
+
+static void
+draw(GFX_CTX *g)
+{
+	int	i;
+
+	for (i = 0; i < 5; i++) {
+		gfx_draw_line_aa(g, 2, 2 + i * 2, 60, 10 + i * 12, GFX_COLOR_WHITE);
+	}
+	gfx_draw_line_aa(g, 4, 60, 14, 20, GFX_COLOR_WHITE);
+	gfx_draw_circle_aa_at(g, 90, 30, 24, GFX_COLOR_WHITE);
+	gfx_draw_circle_aa_at(g, 90, 30, 9, GFX_COLOR_WHITE);
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX		local_context;
+	GFX_CTX		*g;
+	GFX_BITMAP	bm;
+	int			i, bad;
+
+	printf("Anti-aliased lines and circles\n");
+	g = gfx_init(&local_context, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, screen);
+	gfx_set_blend_func(g, blend_pixel);
+	draw(g);
+	print_cover();
+
+	memset(cover, 0, sizeof(cover));
+	gfx_draw_line_aa(g, 3, 5, 120, 40, GFX_COLOR_WHITE);
+	bad = column_errors(3, 120);
+	memset(cover, 0, sizeof(cover));
+	gfx_draw_line_aa(g, 120, 58, 3, 31, GFX_COLOR_WHITE);
+	bad += column_errors(3, 120);
+	printf("Line columns not adding up to one pixel: %d\n", bad);
+
+	/* a circle's top octant has one step per column */
+	memset(cover, 0, sizeof(cover));
+	gfx_draw_circle_aa_at(g, 64, 60, 50, GFX_COLOR_WHITE);
+	printf("Circle columns not adding up to one pixel: %d\n", column_errors(64 - 35, 64 + 35));
+
+	/* blended into a bitmap it comes out the same */
+	memset(cover, 0, sizeof(cover));
+	gfx_set_blend_func(g, blend_pixel);
+	draw(g);
+	gfx_init_bitmap(g, &bm, SWIDTH, SHEIGHT, GFX_FONT_LARGE);
+	bm.pixels = pixels;
+	bm.stride = SWIDTH;
+	gfx_fill_screen(g, GFX_COLOR_BLACK);
+	draw(g);
+	for (bad = 0, i = 0; i < SWIDTH * SHEIGHT; i++) {
+		bad += (pixels[i].c.r != ((cover[i] > 255) ? 255 : cover[i]));
+	}
+	printf("Bitmap pixels that differ from the coverage: %d\n", bad);
+	return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * Simple Graphics - ellipse, arc and pie slice test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Draws outlined and filled ellipses, arcs and pie slices. Then it
+ * checks that slices which go all the way around cover exactly the
+ * filled ellipse, and that a slice stays inside it.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+
+static uint8_t	full[SWIDTH * SHEIGHT];
+
+/* pixels set in 'screen' but not in 'full', and the other way around */
+void
+compare(const char *what)
+{
+	int	i, extra = 0, missing = 0;
+
+	for (i = 0; i < SWIDTH * SHEIGHT; i++) {
+		extra += (screen[i] != ' ') && (full[i] == ' ');
+		missing += (screen[i] == ' ') && (full[i] != ' ');
+	}
+	printf("%s: %d pixels outside the ellipse, %d of it not covered\n",
+		what, extra, missing);
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX	local_context;
+	GFX_CTX	*g;
+
+	g = gfx_init(&local_context, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, screen);
+	printf("Ellipses, arcs and pies\n");
+	gfx_fill_screen(g, C_BLANK);
+	gfx_draw_ellipse_at(g, 20, 15, 18, 12, C_STAR);
+	gfx_fill_ellipse_at(g, 20, 15, 9, 5, C_HASH);
+	gfx_fill_ellipse_at(g, 60, 15, 16, 14, C_DOT);
+	gfx_draw_arc_at(g, 60, 15, 16, 14, 0, 270, C_AT);
+	gfx_fill_pie_at(g, 100, 15, 20, 12, 30, 150, C_PLUS);
+	gfx_draw_pie_at(g, 100, 15, 20, 12, 200, 340, C_EX);
+	gfx_fill_pie_at(g, 20, 46, 16, 16, 90, 45, C_HASH);
+	gfx_draw_arc_at(g, 20, 46, 12, 12, -45, 45, C_AT);
+	gfx_fill_ellipse_at(g, 60, 46, 25, 0, C_DASH);
+	gfx_draw_ellipse_at(g, 60, 46, 0, 10, C_STAR);
+	gfx_fill_pie_at(g, 105, 46, 18, 15, 0, 100, C_PLUS);
+	gfx_fill_pie_at(g, 105, 46, 18, 15, 100, 230, C_DOT);
+	gfx_fill_pie_at(g, 105, 46, 18, 15, 230, 360, C_HASH);
+	print_screen();
+
+	gfx_fill_screen(g, C_BLANK);
+	gfx_fill_ellipse_at(g, 64, 32, 40, 25, C_STAR);
+	memcpy(full, screen, sizeof(screen));
+	gfx_fill_screen(g, C_BLANK);
+	gfx_fill_pie_at(g, 64, 32, 40, 25, 10, 137.5, C_STAR);
+	gfx_fill_pie_at(g, 64, 32, 40, 25, 137.5, 200, C_STAR);
+	gfx_fill_pie_at(g, 64, 32, 40, 25, 200, 370, C_STAR);
+	compare("three slices");
+	gfx_fill_screen(g, C_BLANK);
+	gfx_fill_pie_at(g, 64, 32, 40, 25, 300, 290, C_STAR);
+	gfx_fill_pie_at(g, 64, 32, 40, 25, 290, 300, C_STAR);
+	compare("big and small slice");
+	return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * Simple Graphics - arena allocation test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Everything the library allocates here comes out of one static
+ * block. A context and a view fit, a command queue too big for what
+ * is left is refused (and the arena is untouched), a rounded
+ * rectangle with big corners takes nothing from it, and a reset
+ * hands out the same memory again. Then it draws with the context
+ * it got.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "test.h"
+
+static uint8_t		block[4096];
+
+int
+main(int argc, char *argv[])
+{
+	GFX_ARENA	*a;
+	GFX_CTX		*g, *again;
+	GFX_VIEW	*vp;
+	size_t		used, high;
+
+	printf("Allocating from an arena\n");
+	a = gfx_arena_init(NULL, block, sizeof(block));
+	gfx_set_arena(a);
+
+	g = gfx_init(NULL, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, screen);
+	vp = gfx_viewport(NULL, g, 4, 4, 120, 56, GFX_REAL_INT(0), GFX_REAL_INT(0),
+		GFX_REAL_INT(10), GFX_REAL_INT(10));
+	printf("Context and view from the block: %s\n",
+		((g != NULL) && (vp != NULL) && ((uint8_t *) g >= block) &&
+		 ((uint8_t *) vp < block + sizeof(block))) ? "yes" : "no");
+
+	used = a->used;
+	printf("Queue too big for what is left: %s\n",
+		(gfx_cmdq_init(NULL, NULL, 256) == NULL) ? "refused" : "allocated");
+	printf("Refused allocations: %u, arena untouched: %s\n",
+		(unsigned) a->failed, (a->used == used) ? "yes" : "no");
+
+	/* the corners are stepped as the rows are painted, not tabled */
+	gfx_fill_screen(g, C_BLANK);
+	high = a->high_water;
+	gfx_fill_rounded_rectangle_at(g, -20, 20, 168, 150, 70, C_DOT);
+	printf("Big rounded corners take nothing: %s\n",
+		((a->used == used) && (a->high_water == high)) ? "yes" : "no");
+
+	gfx_arena_reset(a);
+	again = gfx_init(NULL, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, screen);
+	printf("After a reset the same memory is used: %s\n", (again == g) ? "yes" : "no");
+
+	gfx_set_arena(NULL);
+	gfx_draw_rectangle_at(g, 0, 0, SWIDTH, SHEIGHT, C_HASH);
+	gfx_set_text_cursor(g, 36, 30);
+	gfx_set_text_color(g, C_STAR, C_BLANK);
+	gfx_puts(g, "Arena");
+	print_screen();
+	return 0;
+}
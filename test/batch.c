@@ -0,0 +1,90 @@
+/*
+ * Simple Graphics - batch rendering test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Renders a few thousand small numbered "badges" with the batch
+ * API, prints a couple of them so you can see they came out
+ * right, and reports how fast it went. An optional argument sets
+ * the number of threads (default is one per CPU).
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+
+#define BADGES		4000
+#define BADGE_W		28
+#define BADGE_H		10
+
+static uint8_t	badge_fb[BADGES][BADGE_W * BADGE_H];
+static GFX_JOB	jobs[BADGES];
+
+void
+badge_pixel(void *fb, int x, int y, GFX_COLOR color)
+{
+	*((uint8_t *)fb + y * BADGE_W + x) = color.raw & 0xff;
+}
+
+/* draw one badge, arg is the badge number */
+void
+draw_badge(GFX_CTX *g, void *arg)
+{
+	char	label[8];
+
+	gfx_fill_screen(g, C_BLANK);
+	gfx_draw_rectangle_at(g, 0, 0, BADGE_W, BADGE_H, C_HASH);
+	snprintf(label, sizeof(label), "%d", (int)(intptr_t) arg);
+	gfx_set_text_color(g, C_STAR, C_STAR);
+	gfx_set_text_cursor(g, 2, 8);
+	gfx_puts(g, label);
+}
+
+void
+print_badge(int n)
+{
+	int x, y;
+
+	printf("Badge %d:\n", n);
+	for (y = 0; y < BADGE_H; y++) {
+		for (x = 0; x < BADGE_W; x++) {
+			printf("%c", (char) badge_fb[n][y * BADGE_W + x]);
+		}
+		printf("\n");
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_BATCH_STATS	st;
+	int i, threads = 0;
+
+	if (argc == 2) {
+		threads = atoi(argv[1]);
+	}
+	for (i = 0; i < BADGES; i++) {
+		jobs[i].fb = badge_fb[i];
+		jobs[i].draw = badge_pixel;
+		jobs[i].w = BADGE_W;
+		jobs[i].h = BADGE_H;
+		jobs[i].render = draw_badge;
+		jobs[i].arg = (void *)(intptr_t) i;
+	}
+	gfx_batch_render(jobs, BADGES, threads, GFX_FONT_TINY, &st);
+	print_badge(7);
+	print_badge(BADGES - 1);
+	printf("%d jobs, %d threads, %llu pixels in %u usec\n", st.jobs,
+		st.threads, (unsigned long long) st.pixels, st.usec);
+	printf("%.0f jobs/sec, %.2f Mpixels/sec\n", st.jobs_per_sec,
+		st.mpixels_per_sec);
+	return 0;
+}
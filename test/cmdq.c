@@ -0,0 +1,97 @@
+/*
+ * Simple Graphics - command queue test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Three producer threads (a status bar, a plot, and an alarm box)
+ * draw through a deliberately small command queue while the main
+ * thread drains it into the screen. Producers retry when the queue
+ * is full, so the picture should come out complete and the stats
+ * show how often they were pushed back. Afterwards a command that
+ * doesn't fit the queue's co-ordinates is refused, and the text
+ * commands have left the context's own text colors alone.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "test.h"
+
+static GFX_CMDQ	q;
+static GFX_CMD	slots[16];
+static int		done;
+
+/* keep trying until the command is queued */
+#define PUT(x)	while ((x) != 0) { sched_yield(); }
+
+static void *
+status_bar(void *arg)
+{
+	PUT(gfx_cmdq_fill_rectangle(&q, 0, 0, SWIDTH, 12, C_DASH));
+	PUT(gfx_cmdq_puts(&q, 2, 10, "Status: OK", C_HASH, C_DASH));
+	__sync_fetch_and_add(&done, 1);
+	return NULL;
+}
+
+static void *
+plot(void *arg)
+{
+	int x;
+
+	PUT(gfx_cmdq_rectangle(&q, 0, 14, 80, SHEIGHT - 14, C_DOT));
+	for (x = 2; x < 78; x++) {
+		PUT(gfx_cmdq_point(&q, x, 38 + ((x * 7) % 21) - 10, C_STAR));
+	}
+	__sync_fetch_and_add(&done, 1);
+	return NULL;
+}
+
+static void *
+alarm_box(void *arg)
+{
+	PUT(gfx_cmdq_fill_circle(&q, 104, 38, 16, C_AT));
+	PUT(gfx_cmdq_fill_triangle(&q, 104, 26, 94, 46, 114, 46, C_PLUS));
+	__sync_fetch_and_add(&done, 1);
+	return NULL;
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CMDQ_STATS	st;
+	GFX_CTX		*g;
+	pthread_t	t[3];
+	int			i;
+
+	g = gfx_init(NULL, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_SMALL, (void *)screen);
+	gfx_fill_screen(g, C_BLANK);
+	gfx_set_text_color(g, C_STAR, C_BLANK);
+	gfx_cmdq_init(&q, slots, 16);
+	pthread_create(&t[0], NULL, status_bar, NULL);
+	pthread_create(&t[1], NULL, plot, NULL);
+	pthread_create(&t[2], NULL, alarm_box, NULL);
+	while (__sync_fetch_and_add(&done, 0) < 3) {
+		gfx_cmdq_drain(&q, g, 0);
+	}
+	for (i = 0; i < 3; i++) {
+		pthread_join(t[i], NULL);
+	}
+	gfx_cmdq_drain(&q, g, 0);
+	print_screen();
+	gfx_cmdq_stats(&q, &st);
+	printf("queued %u, drained %u, depth %u of %u, high water %u, full %u\n",
+		st.queued, st.drained, st.depth, st.size, st.high_water, st.full);
+	printf("Line out to x = 40000: %s\n",
+		(gfx_cmdq_line(&q, 0, 0, 40000, 0, C_STAR) == -1) ? "refused" : "queued");
+	printf("Text colors kept: %s\n",
+		((g->text.fg.raw == C_STAR.raw) && (g->text.bg.raw == C_BLANK.raw)) ? "yes" : "no");
+	return 0;
+}
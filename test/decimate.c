@@ -0,0 +1,75 @@
+/*
+ * Simple Graphics - decimated plotting test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Plots a quarter million samples of a noisy sine wave into a
+ * 128 pixel wide viewport, once drawing every segment and once
+ * with column decimation on. The two images have to be the same,
+ * and we count pixel writes to show how much less work the
+ * decimated plot does.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "test.h"
+
+#define SAMPLES	250000
+
+static float		xs[SAMPLES], ys[SAMPLES];
+static uint8_t		ref[SWIDTH * SHEIGHT];
+static unsigned long	writes;
+
+void
+count_pixel(void *fb, int x, int y, GFX_COLOR color)
+{
+	writes++;
+	draw_pixel(fb, x, y, color);
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX		*g;
+	GFX_VIEW	*vp;
+	unsigned long	full;
+	uint32_t	seed = 1;
+	int			i;
+
+	printf("Testing decimated series plotting\n");
+	for (i = 0; i < SAMPLES; i++) {
+		seed = seed * 1103515245 + 12345;
+		xs[i] = 2 * M_PI * i / SAMPLES;
+		ys[i] = 0.8 * sin(xs[i]) + 0.15 * (((seed >> 16) & 0x7fff) / 32768.0 - 0.5);
+	}
+	g = gfx_init(NULL, count_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, (void *)screen);
+	vp = gfx_viewport(NULL, g, 0, 0, SWIDTH, SHEIGHT, GFX_REAL_INT(0), GFX_REAL_CONST(-1.0),
+		GFX_REAL_CONST(2 * M_PI), GFX_REAL_CONST(1.0));
+
+	gfx_fill_screen(g, C_BLANK);
+	writes = 0;
+	vp_plot_series(vp, xs, ys, SAMPLES, C_STAR);
+	full = writes;
+	memcpy(ref, screen, sizeof(ref));
+
+	gfx_fill_screen(g, C_BLANK);
+	writes = 0;
+	vp_set_decimate(vp, 1);
+	vp_plot_series(vp, xs, ys, SAMPLES, C_STAR);
+	print_screen();
+
+	printf("%d samples, %lu pixel writes full, %lu decimated\n", SAMPLES,
+		full, writes);
+	printf("Decimated plot %s the full plot\n",
+		(memcmp(ref, screen, sizeof(ref)) == 0) ? "matches" : "DOES NOT match");
+	return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * Simple Graphics - cached viewport decorations test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Draws a few frames of a moving sine wave over axes, a grid and
+ * labels. The decorations should only be drawn into their layer once
+ * and just copied for every other frame, until the view is rescaled.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include "test.h"
+
+#define FRAMES	5
+#define POINTS	200
+
+static GFX_COLOR	pixels[SWIDTH * SHEIGHT];
+static GFX_COLOR	layer[SWIDTH * SHEIGHT];
+static float		xs[POINTS], ys[POINTS];
+
+void
+print_bitmap(GFX_COLOR *p)
+{
+	int	x, y;
+
+	for (y = 0; y < SHEIGHT; y++) {
+		for (x = 0; x < SWIDTH; x++) {
+			printf("%c", (char) (p[y * SWIDTH + x].raw & 0xff));
+		}
+		printf("\n");
+	}
+}
+
+/* one frame, decorations and then the data */
+void
+frame(GFX_DECOR *d, float phase)
+{
+	int	i;
+
+	for (i = 0; i < POINTS; i++) {
+		xs[i] = 10.0 * i / (POINTS - 1);
+		ys[i] = 0.8 * sin(xs[i] + phase);
+	}
+	vp_decor_draw(d);
+	vp_plot_series(d->vp, xs, ys, POINTS, C_STAR);
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX		g;
+	GFX_BITMAP	bm;
+	GFX_VIEW	vp;
+	GFX_DECOR	dec;
+	int			i;
+
+	printf("Testing cached viewport decorations\n");
+	bm.pixels = pixels;
+	bm.stride = SWIDTH;
+	gfx_init_bitmap(&g, &bm, SWIDTH, SHEIGHT, GFX_FONT_TINY);
+	gfx_viewport(&vp, &g, 16, 2, 108, 50, GFX_REAL_INT(0), GFX_REAL_INT(-1), GFX_REAL_INT(10),
+		GFX_REAL_INT(1));
+	vp_decor_init(&dec, &vp, 0, 0, SWIDTH, SHEIGHT, layer,
+		VP_DECOR_AXES | VP_DECOR_GRID | VP_DECOR_TICKS | VP_DECOR_LABELS);
+	vp_decor_colors(&dec, C_BLANK, C_HASH, C_DOT, C_AT);
+	dec.font = GFX_FONT_TINY;
+
+	for (i = 0; i < FRAMES; i++) {
+		frame(&dec, i * 0.5);
+	}
+	print_bitmap(pixels);
+	printf("%d frames, decorations drawn %u time(s)\n", FRAMES, dec.renders);
+
+	vp_rescale(&vp, GFX_REAL_INT(0), GFX_REAL_INT(0), GFX_REAL_INT(5), GFX_REAL_INT(1));
+	for (i = 0; i < FRAMES; i++) {
+		frame(&dec, i * 0.5);
+	}
+	print_bitmap(pixels);
+	printf("rescaled, %d more frames, decorations drawn %u time(s)\n", FRAMES,
+		dec.renders);
+	return 0;
+}
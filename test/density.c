@@ -0,0 +1,113 @@
+/*
+ * Simple Graphics - density plot test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Builds an eye diagram out of a long noisy random bit stream by
+ * counting every sample into a density plot, once on one thread and
+ * once on several, and checks the counts agree. The picture uses
+ * characters of increasing "weight" as its color table.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "test.h"
+
+#define BITS		20000
+#define PER_BIT		64
+#define SAMPLES		(BITS * PER_BIT)
+
+static float		xs[SAMPLES], ys[SAMPLES];
+static uint32_t		counts[SWIDTH * SHEIGHT];
+static uint32_t		single[SWIDTH * SHEIGHT];
+static GFX_COLOR	pixels[SWIDTH * SHEIGHT];
+static const char	shades[] = " .:-=+*#%@";
+
+void
+print_bitmap(GFX_COLOR *p)
+{
+	int	x, y;
+
+	for (y = 0; y < SHEIGHT; y++) {
+		for (x = 0; x < SWIDTH; x++) {
+			printf("%c", (char) (p[y * SWIDTH + x].raw & 0xff));
+		}
+		printf("\n");
+	}
+}
+
+static unsigned
+usec(struct timespec *t0, struct timespec *t1)
+{
+	return (t1->tv_sec - t0->tv_sec) * 1000000 + (t1->tv_nsec - t0->tv_nsec) / 1000;
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX			g;
+	GFX_BITMAP		bm;
+	GFX_VIEW		vp;
+	GFX_DENSITY		den;
+	GFX_COLOR		lut[sizeof(shades) - 1];
+	struct timespec	t0, t1, t2;
+	uint32_t		seed = 1;
+	float			level = -1, next, t;
+	int				i, b, s, diff;
+
+	printf("Testing density plots\n");
+	/* NRZ bits with a raised cosine edge and a little noise, 2 UI per trace */
+	for (b = 0; b < BITS; b++) {
+		seed = seed * 1103515245 + 12345;
+		next = (seed & 0x10000) ? 1 : -1;
+		for (s = 0; s < PER_BIT; s++) {
+			i = b * PER_BIT + s;
+			t = (float) s / PER_BIT;
+			seed = seed * 1103515245 + 12345;
+			ys[i] = level + (next - level) * (0.5 - 0.5 * cos(M_PI * t)) +
+				(((seed >> 16) & 0xff) - 128) / 1600.0;
+			xs[i] = t + (b & 1);
+		}
+		level = next;
+	}
+	for (i = 0; i < (int) sizeof(lut) / (int) sizeof(lut[0]); i++) {
+		lut[i].raw = shades[i];
+	}
+	bm.pixels = pixels;
+	bm.stride = SWIDTH;
+	gfx_init_bitmap(&g, &bm, SWIDTH, SHEIGHT, GFX_FONT_LARGE);
+	gfx_fill_screen(&g, C_DOT);
+	gfx_viewport(&vp, &g, 4, 2, 119, 59, GFX_REAL_INT(0), GFX_REAL_CONST(-1.3), GFX_REAL_INT(2),
+		GFX_REAL_CONST(1.3));
+
+	vp_density_init(&den, &vp, single);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	vp_density_add(&den, xs, ys, SAMPLES, 1);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	vp_density_init(&den, &vp, counts);
+	vp_density_add(&den, xs, ys, SAMPLES, 4);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("%d samples binned in %u usec on one thread, %u usec on four\n",
+		SAMPLES, usec(&t0, &t1), usec(&t1, &t2));
+	diff = memcmp(single, counts, den.w * den.h * sizeof(uint32_t));
+	printf("%llu points, largest count %u, threaded counts %s\n",
+		(unsigned long long) den.points, den.max, (diff) ? "DIFFER" : "match");
+
+	vp_density_draw(&den, lut, sizeof(lut) / sizeof(lut[0]), 0);
+	printf("Linear:\n");
+	print_bitmap(pixels);
+	vp_density_draw(&den, lut, sizeof(lut) / sizeof(lut[0]), VP_DENSITY_LOG);
+	printf("Logarithmic:\n");
+	print_bitmap(pixels);
+	return 0;
+}
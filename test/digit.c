@@ -153,6 +153,7 @@ draw_digit(GFX_CTX *g, int x, int y, int d, GFX_COLOR color, GFX_COLOR outline)
 	int i;
 	uint8_t seg_mask;
 	int	sx, sy, ndx, xf, yf;
+	int	pts[14];
 
 	seg_mask = seg_map[d % 10];
 
@@ -172,44 +173,18 @@ draw_digit(GFX_CTX *g, int x, int y, int d, GFX_COLOR color, GFX_COLOR outline)
 			sy = y + segment_data[i].yo;
 			xf = segment_data[i].xf;
 			yf = segment_data[i].yf;
-			/* tesselate it */
-			for (ndx = 2; ndx < (segment_data[i].n_coords - 1) * 2; ndx += 2) {
-				/* move to segment reference point given X, Y, and Skew */
-				gfx_move(g, sx, sy);
-					
-				gfx_fill_triangle_abs(g,
-					skew_factor((sy + *(segment_data[i].segs + 1) * yf - y), DISP_HEIGHT) +
-							sx + *(segment_data[i].segs) * xf,
-					sy + *(segment_data[i].segs + 1) * yf,			/* #1 */
-
-					skew_factor((sy + *(segment_data[i].segs + ndx + 1) * yf - y), DISP_HEIGHT) +
-						sx	+ *(segment_data[i].segs + ndx) * xf,
-					sy + *(segment_data[i].segs + ndx + 1) * yf,	/* #2 */
-
-					skew_factor((sy + *(segment_data[i].segs + ndx + 3) * yf - y), DISP_HEIGHT) +
-					     sx + *(segment_data[i].segs + ndx + 2) * xf,
-					sy + *(segment_data[i].segs + ndx + 3) * yf,	/* #3 */
-							 color);
+			/* the segment's outline in display co-ordinates */
+			for (ndx = 0; ndx < segment_data[i].n_coords; ndx++) {
+				pts[ndx * 2 + 1] = sy + *(segment_data[i].segs + ndx * 2 + 1) * yf;
+				pts[ndx * 2] = skew_factor(pts[ndx * 2 + 1] - y, DISP_HEIGHT) +
+							sx + *(segment_data[i].segs + ndx * 2) * xf;
 			}
+			/* fill it in one pass */
+			gfx_fill_polygon(g, pts, segment_data[i].n_coords, color);
 			/* outline it */
-			for (ndx = 0; ndx < (segment_data[i].n_coords - 1) * 2; ndx += 2) {
-				gfx_draw_line_at(g,
-					skew_factor((sy + *(segment_data[i].segs + ndx + 1) * yf - y), DISP_HEIGHT) +
-						sx + *(segment_data[i].segs + ndx) * xf,
-					sy + *(segment_data[i].segs + ndx + 1) * yf,
-					skew_factor((sy + *(segment_data[i].segs + ndx + 3) * yf - y), DISP_HEIGHT) +
-								sx	+ *(segment_data[i].segs + ndx + 2) * xf,
-					sy + *(segment_data[i].segs + ndx + 3) * yf,
-								outline);
-			}
-			gfx_draw_line_at(g,
-				skew_factor((sy + *(segment_data[i].segs + 1) * yf - y), DISP_HEIGHT) +
-							sx + *(segment_data[i].segs + 0) * xf,
-				sy + *(segment_data[i].segs + 1) * yf,
-				skew_factor((sy + *(segment_data[i].segs + ndx + 1) * yf - y), DISP_HEIGHT) +
-							sx + *(segment_data[i].segs + ndx) * xf,
-				sy + *(segment_data[i].segs + ndx + 1) * yf,
-							outline);
+			pts[ndx * 2] = pts[0];
+			pts[ndx * 2 + 1] = pts[1];
+			gfx_draw_polyline(g, pts, segment_data[i].n_coords + 1, outline);
 		} else {
 			/* draw 'off' segment? */
 #ifdef DRAW_DARK_SEGMENT
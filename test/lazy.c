@@ -0,0 +1,66 @@
+/*
+ * Simple Graphics - lazy clear test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Draws into a plain GFX_BITMAP with lazy clearing turned on. The
+ * screen is "cleared" twice, once to '.' and then to ' ', and then
+ * a few things are drawn. Before the flush any tile that was never
+ * drawn on still holds whatever was there before (we pre-fill the
+ * buffer with 'x' to make that visible), after the flush the whole
+ * screen should look like it was cleared to ' ' and then drawn on.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+
+static GFX_COLOR	pixels[SWIDTH * SHEIGHT];
+static uint32_t		tiles[GFX_LAZY_WORDS(SWIDTH, SHEIGHT)];
+
+static void
+print_bitmap(void)
+{
+	int x, y;
+
+	for (y = 0; y < SHEIGHT; y++) {
+		for (x = 0; x < SWIDTH; x++) {
+			printf("%c", (char) (pixels[y * SWIDTH + x].raw & 0xff));
+		}
+		printf("\n");
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_BITMAP	bm = { pixels, SWIDTH };
+	GFX_CTX		*g;
+	int			i;
+
+	for (i = 0; i < SWIDTH * SHEIGHT; i++) {
+		pixels[i] = C_EX;
+	}
+	g = gfx_init_bitmap(NULL, &bm, SWIDTH, SHEIGHT, GFX_FONT_LARGE);
+	gfx_set_lazy_clear(g, tiles);
+	gfx_fill_screen(g, C_DOT);
+	gfx_fill_screen(g, C_BLANK);
+	gfx_fill_circle_at(g, 20, 20, 12, C_STAR);
+	gfx_draw_line_abs(g, 40, 50, 120, 40, C_HASH);
+	gfx_set_text_cursor(g, 40, 20);
+	gfx_set_text_color(g, C_AT, C_AT);
+	gfx_puts(g, "Lazy");
+	printf("Before flush:\n");
+	print_bitmap();
+	gfx_flush(g);
+	printf("After flush:\n");
+	print_bitmap();
+	return 0;
+}
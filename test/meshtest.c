@@ -0,0 +1,73 @@
+/*
+ * Simple Graphics - triangle mesh test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Builds a grid of jittered vertices, splits every cell into two
+ * triangles and fills the lot with one gfx_fill_triangles call.
+ * The pixel function counts how many times each pixel is painted
+ * so the picture shows '1' everywhere inside the mesh. Any '2' is
+ * a double painted seam and any '.' inside the mesh is a gap.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+
+#define COLS	16
+#define ROWS	9
+
+static int	verts[(COLS + 1) * (ROWS + 1) * 2];
+static int	indices[COLS * ROWS * 6];
+
+/* count paints rather than store a color */
+void
+count_pixel(void *fb, int x, int y, GFX_COLOR color) {
+	uint8_t *s = fb;
+	s[y * SWIDTH + x] = (s[y * SWIDTH + x] == ' ') ? '1' : s[y * SWIDTH + x] + 1;
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX	*g;
+	int		i, j, n = 0, seams = 0;
+
+	memset(screen, ' ', sizeof(screen));
+	g = gfx_init(NULL, count_pixel, SWIDTH, SHEIGHT, GFX_FONT_SMALL, (void *)screen);
+	srand(1);
+	for (j = 0; j <= ROWS; j++) {
+		for (i = 0; i <= COLS; i++) {
+			verts[(j * (COLS + 1) + i) * 2] = 4 + i * 7 +
+				(((i > 0) && (i < COLS)) ? (rand() % 3) - 1 : 0);
+			verts[(j * (COLS + 1) + i) * 2 + 1] = 4 + j * 6 +
+				(((j > 0) && (j < ROWS)) ? (rand() % 3) - 1 : 0);
+		}
+	}
+	for (j = 0; j < ROWS; j++) {
+		for (i = 0; i < COLS; i++) {
+			int a = j * (COLS + 1) + i;
+			indices[n++] = a;
+			indices[n++] = a + 1;
+			indices[n++] = a + COLS + 2;
+			indices[n++] = a;
+			indices[n++] = a + COLS + 2;
+			indices[n++] = a + COLS + 1;
+		}
+	}
+	gfx_fill_triangles(g, verts, indices, n / 3, C_STAR);
+	for (i = 0; i < SWIDTH * SHEIGHT; i++) {
+		seams += (screen[i] > '1');
+	}
+	print_screen();
+	printf("%d triangles, %d pixels painted more than once\n", n / 3, seams);
+	return 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * Simple Graphics - viewport pan and zoom test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Pans a view of a long series around with vp_pan(), which only
+ * redraws the bands that scroll in, and after each pan compares it
+ * with the same view drawn from scratch, which has to match exactly. Then it zooms out using an
+ * M4 cache of the series instead of the samples and compares that
+ * with plotting the samples.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "test.h"
+
+#define SAMPLES	20000
+#define BINS	2048
+
+static float		xs[SAMPLES], ys[SAMPLES];
+static GFX_COLOR	pan_pixels[SWIDTH * SHEIGHT];
+static GFX_COLOR	ref_pixels[SWIDTH * SHEIGHT];
+static GFX_M4_BIN	bins[BINS];
+static unsigned long	band_pixels;
+
+/* redraw function, plots every sample, the clip does the rest */
+void
+redraw_series(GFX_VIEW *vp, int x, int y, int w, int h, void *arg)
+{
+	band_pixels += w * h;
+	gfx_fill_rectangle_at(vp->g, x, y, w, h, C_BLANK);
+	vp_plot_series(vp, xs, ys, SAMPLES, C_STAR);
+}
+
+/* redraw function, plots the M4 cache */
+void
+redraw_m4(GFX_VIEW *vp, int x, int y, int w, int h, void *arg)
+{
+	gfx_fill_rectangle_at(vp->g, x, y, w, h, C_BLANK);
+	vp_m4_plot(vp, (GFX_M4 *) arg, C_STAR);
+}
+
+int
+differences(void)
+{
+	int	i, n = 0;
+
+	for (i = 0; i < SWIDTH * SHEIGHT; i++) {
+		n += (pan_pixels[i].raw != ref_pixels[i].raw);
+	}
+	return n;
+}
+
+void
+print_bitmap(GFX_COLOR *p)
+{
+	int	x, y;
+
+	for (y = 0; y < SHEIGHT; y++) {
+		for (x = 0; x < SWIDTH; x++) {
+			printf("%c", (char) (p[y * SWIDTH + x].raw & 0xff));
+		}
+		printf("\n");
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX		g, rg;
+	GFX_BITMAP	bm, ref;
+	GFX_VIEW	vp, rvp;
+	GFX_M4		m4;
+	int			pans[][2] = { { -7, 0 }, { -7, 0 }, { -30, 0 }, { 4, 3 },
+							  { 0, -5 }, { -9, 2 }, { 12, -1 } };
+	int			i, diff, failed = 0;
+
+	printf("Testing viewport pan and zoom\n");
+	for (i = 0; i < SAMPLES; i++) {
+		xs[i] = 20.0 * i / SAMPLES;
+		ys[i] = sin(xs[i] * 2) * 0.8 + 0.1 * sin(xs[i] * 37);
+	}
+	bm.pixels = pan_pixels;
+	bm.stride = SWIDTH;
+	gfx_init_bitmap(&g, &bm, SWIDTH, SHEIGHT, GFX_FONT_LARGE);
+	ref.pixels = ref_pixels;
+	ref.stride = SWIDTH;
+	gfx_init_bitmap(&rg, &ref, SWIDTH, SHEIGHT, GFX_FONT_LARGE);
+	gfx_fill_screen(&g, C_DOT);
+	gfx_fill_screen(&rg, C_DOT);
+
+	gfx_viewport(&vp, &g, 8, 4, 100, 50, GFX_REAL_INT(0), GFX_REAL_INT(-1), GFX_REAL_INT(5),
+		GFX_REAL_INT(1));
+	vp_set_redraw(&vp, redraw_series, NULL);
+	gfx_viewport(&rvp, &rg, 8, 4, 100, 50, GFX_REAL_INT(0), GFX_REAL_INT(-1), GFX_REAL_INT(5),
+		GFX_REAL_INT(1));
+	vp_set_redraw(&rvp, redraw_series, NULL);
+	vp_zoom(&vp, 1, 0, 0);
+
+	for (i = 0; i < (int) (sizeof(pans) / sizeof(pans[0])); i++) {
+		band_pixels = 0;
+		vp_pan(&vp, pans[i][0], pans[i][1]);
+		/* same view with the same scaling, drawn from scratch */
+		memcpy(&rvp, &vp, sizeof(GFX_VIEW));
+		rvp.g = &rg;
+		redraw_series(&rvp, rvp.x, rvp.y, rvp.w + 1, rvp.h + 1, NULL);
+		diff = differences();
+		failed |= (diff != 0);
+		band_pixels -= (vp.w + 1) * (vp.h + 1);
+		printf("pan %3d, %3d: redrew %4lu of %d pixels, %d differ from a full redraw\n",
+			pans[i][0], pans[i][1], band_pixels, (vp.w + 1) * (vp.h + 1), diff);
+	}
+	print_bitmap(pan_pixels);
+
+	/* zoom out 4x from the M4 cache, and again from the samples */
+	vp_m4_init(&m4, bins, BINS, 0, 20.0 / BINS);
+	vp_m4_add(&m4, xs, ys, SAMPLES);
+	vp_set_redraw(&vp, redraw_m4, &m4);
+	vp_zoom(&vp, 0.25, vp.min_x, 0);
+	memcpy(&rvp, &vp, sizeof(GFX_VIEW));
+	rvp.g = &rg;
+	vp_set_decimate(&rvp, 1);
+	vp_zoom(&rvp, 1, 0, 0);
+	print_bitmap(pan_pixels);
+	printf("zoomed out from %d cached bins, %d pixels differ from plotting %d samples\n",
+		BINS, differences(), SAMPLES);
+	return failed;
+}
@@ -0,0 +1,120 @@
+/*
+ * Simple Graphics - persistence test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Checks both kinds of fade against doing the arithmetic a channel
+ * at a time, then draws a few frames of a drifting sine wave with a
+ * fade between each so the older traces show dimmer. Brightness is
+ * printed as characters of increasing "weight".
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "test.h"
+
+#define FRAMES	6
+#define POINTS	120
+
+static GFX_COLOR	pixels[SWIDTH * SHEIGHT];
+static GFX_COLOR	ref[SWIDTH * SHEIGHT];
+static const char	shades[] = " .:-=+*#%@";
+
+/* print the green channel as a shade */
+void
+print_green(GFX_COLOR *p)
+{
+	int	x, y;
+
+	for (y = 0; y < SHEIGHT; y++) {
+		for (x = 0; x < SWIDTH; x++) {
+			printf("%c", shades[(p[y * SWIDTH + x].c.g * 9 + 254) / 255]);
+		}
+		printf("\n");
+	}
+}
+
+static unsigned
+usec(struct timespec *t0, struct timespec *t1)
+{
+	return (t1->tv_sec - t0->tv_sec) * 1000000 + (t1->tv_nsec - t0->tv_nsec) / 1000;
+}
+
+/* the slow way, one channel at a time */
+static void
+fade_ref(int amount, int sub)
+{
+	int		i, c;
+	uint8_t	*ch;
+
+	for (i = 0; i < SWIDTH * SHEIGHT; i++) {
+		ch = (uint8_t *) &ref[i].raw;
+		for (c = 0; c < 3; c++) {
+			ch[c] = (sub) ? ((ch[c] > amount) ? ch[c] - amount : 0) :
+							(ch[c] * amount) >> 8;
+		}
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX			g;
+	GFX_BITMAP		bm;
+	GFX_VIEW		vp;
+	struct timespec	t0, t1;
+	float			xs[POINTS], ys[POINTS];
+	uint32_t		seed = 99;
+	int				i, f, diff = 0;
+	int				amounts[] = { 0, 1, 77, 128, 200, 255, 256 };
+
+	printf("Testing persistence fades\n");
+	bm.pixels = pixels;
+	bm.stride = SWIDTH;
+	gfx_init_bitmap(&g, &bm, SWIDTH, SHEIGHT, GFX_FONT_LARGE);
+	for (f = 0; f < (int) (sizeof(amounts) / sizeof(amounts[0])); f++) {
+		for (i = 0; i < SWIDTH * SHEIGHT; i++) {
+			seed = seed * 1103515245 + 12345;
+			pixels[i].raw = seed ^ (seed << 13);
+		}
+		memcpy(ref, pixels, sizeof(ref));
+		gfx_fade_rect(&g, 0, 0, SWIDTH, SHEIGHT, amounts[f], 0);
+		fade_ref(amounts[f], 0);
+		diff += memcmp(pixels, ref, sizeof(ref)) != 0;
+		gfx_fade_rect(&g, 0, 0, SWIDTH, SHEIGHT, amounts[f], GFX_FADE_SUB);
+		fade_ref((amounts[f] > 255) ? 255 : amounts[f], 1);
+		diff += memcmp(pixels, ref, sizeof(ref)) != 0;
+	}
+	printf("scale and subtract fades: %d of %d differ from per channel math\n",
+		diff, 2 * (int) (sizeof(amounts) / sizeof(amounts[0])));
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < 1000; i++) {
+		gfx_fade_rect(&g, 0, 0, SWIDTH, SHEIGHT, 240, 0);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	printf("faded %d pixels in %u usec\n", 1000 * SWIDTH * SHEIGHT, usec(&t0, &t1));
+
+	gfx_fill_screen(&g, GFX_COLOR_BLACK);
+	gfx_viewport(&vp, &g, 4, 2, 119, 59, GFX_REAL_INT(0), GFX_REAL_INT(-1), GFX_REAL_INT(1),
+		GFX_REAL_INT(1));
+	for (f = 0; f < FRAMES; f++) {
+		vp_fade(&vp, 150, 0);
+		for (i = 0; i < POINTS; i++) {
+			xs[i] = (float) i / (POINTS - 1);
+			ys[i] = 0.9 * sin(6.2831853 * xs[i] + f * 0.5);
+		}
+		vp_plot_series(&vp, xs, ys, POINTS, GFX_COLOR_GREEN);
+	}
+	print_green(pixels);
+	return 0;
+}
@@ -27,15 +27,18 @@
  */
 int
 main(int argc, char *argv[]) {
-	int a, b;
+	int a, b, n;
 	float i, x0, y0;
+	float xs[128], ys[128];
+	uint8_t ref[SWIDTH * SHEIGHT];
 	GFX_CTX *g;
 	GFX_VIEW *vp;
 	printf("Testing the graphics viewport code\n");
 	
 	g = gfx_init(NULL, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, (void *)screen);
 	gfx_fill_screen(g, C_BLANK);
-	vp = gfx_viewport(NULL, g, 0, 0, SWIDTH, SHEIGHT, 0, -1.0, 2 * M_PI, 1.0);
+	vp = gfx_viewport(NULL, g, 0, 0, SWIDTH, SHEIGHT, GFX_REAL_INT(0), GFX_REAL_CONST(-1.0),
+		GFX_REAL_CONST(2 * M_PI), GFX_REAL_CONST(1.0));
 	x0 = 0;
 	y0 = sin(0);
 	for (i = 2 * M_PI / 100.0; i < 2 * M_PI; i += 2 * M_PI / 100.0) {
@@ -44,4 +47,18 @@ main(int argc, char *argv[]) {
 		y0 = sin(i);
 	}
 	print_screen();
+
+	/* same curve as one series, it should paint exactly the same pixels */
+	memcpy(ref, screen, sizeof(ref));
+	gfx_fill_screen(g, C_BLANK);
+	n = 0;
+	xs[n] = 0;
+	ys[n++] = sin(0);
+	for (i = 2 * M_PI / 100.0; i < 2 * M_PI; i += 2 * M_PI / 100.0) {
+		xs[n] = i;
+		ys[n++] = sin(i);
+	}
+	vp_plot_series(vp, xs, ys, n, C_STAR);
+	printf("vp_plot_series of %d points %s vp_plot\n", n,
+		(memcmp(ref, screen, sizeof(ref)) == 0) ? "matches" : "DOES NOT match");
 }
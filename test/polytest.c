@@ -0,0 +1,70 @@
+/*
+ * Simple Graphics - polygon test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Fills a five pointed star with the even-odd rule (the center
+ * stays empty) and with the non-zero rule (the center is filled),
+ * then a convex hexagon next to its outline drawn with
+ * gfx_draw_polyline. Two squares that share an edge are filled
+ * in different colors, the shared edge should belong to just one
+ * of them. An octagon with a vertex on every pixel of its edges (64
+ * of them) is filled, a concave gear with more than GFX_POLY_MAX
+ * vertices is refused.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "test.h"
+
+static const int star[] = { 20, 2, 31, 36, 2, 14, 38, 14, 9, 36 };
+static const int hex[] = { 76, 4, 92, 4, 100, 18, 92, 32, 76, 32, 68, 18, 76, 4 };
+static const int left_sq[] = { 104, 40, 114, 40, 114, 50, 104, 50 };
+static const int right_sq[] = { 114, 40, 124, 40, 124, 50, 114, 50 };
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX	*g;
+	const int	step[8][2] = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 },
+						   { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+	int		pts[10], oct[128], gear[80];
+	int		i, x, y;
+
+	g = gfx_init(NULL, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_SMALL, (void *)screen);
+	gfx_fill_screen(g, C_BLANK);
+	gfx_fill_polygon(g, star, 5, C_STAR);
+	for (i = 0; i < 10; i += 2) {
+		pts[i] = star[i] + 40;
+		pts[i + 1] = star[i + 1] + 24;
+	}
+	gfx_set(g, GFX_FILL_NONZERO);
+	gfx_fill_polygon(g, pts, 5, C_AT);
+	gfx_clear(g, GFX_FILL_NONZERO);
+	gfx_fill_polygon(g, hex, 6, C_PLUS);
+	gfx_draw_polyline(g, hex, 7, C_HASH);
+	gfx_fill_polygon(g, left_sq, 4, C_DOT);
+	gfx_fill_polygon(g, right_sq, 4, C_DASH);
+	for (i = 0, x = 8, y = 39; i < 64; i++) {
+		oct[i * 2] = x;
+		oct[i * 2 + 1] = y;
+		x += step[i / 8][0];
+		y += step[i / 8][1];
+	}
+	printf("64 vertex octagon: %d\n", gfx_fill_polygon(g, oct, 64, C_EX));
+	for (i = 0; i < 40; i++) {
+		gear[i * 2] = 14 + (int) lround(((i & 1) ? 6 : 10) * cos(i * M_PI / 20));
+		gear[i * 2 + 1] = 51 + (int) lround(((i & 1) ? 6 : 10) * sin(i * M_PI / 20));
+	}
+	printf("40 sided concave polygon: %d\n", gfx_fill_polygon(g, gear, 40, C_STAR));
+	print_screen();
+	return 0;
+}
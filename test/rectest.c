@@ -13,13 +13,22 @@
 #include <string.h>
 #include "test.h"
 
+static uint8_t	paints[SWIDTH * SHEIGHT];
+
+/* count how many times each pixel is painted */
+void
+count_pixel(void *fb, int x, int y, GFX_COLOR color)
+{
+	paints[y * SWIDTH + x]++;
+}
+
 /*
  * Run through the basic operations of the graphics library
  * to verify they work correctly.
  */
 int
 main(int argc, char *argv[]) {
-	int i, a, b;
+	int i, a, b, k;
 	int mode = 0;
 	GFX_CTX *g;
 	printf("Triangle Testing\n");
@@ -40,6 +49,25 @@ main(int argc, char *argv[]) {
 	gfx_move(g, 41, 0);
 	gfx_fill_rounded_rectangle(g, 40, 20, 7, C_STAR);
 	print_screen();
+
+	/* rounded rectangles are painted a row at a time, nothing twice */
+	g = gfx_init(NULL, count_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, NULL);
+	for (a = 0; a < 2; a++) {
+		b = 0;
+		for (i = 1; i <= 20; i++) {
+			memset(paints, 0, sizeof(paints));
+			if (a) {
+				gfx_fill_rounded_rectangle_at(g, 10, 5, 41 + i, 2 * i + 1, i, C_STAR);
+			} else {
+				gfx_draw_rounded_rectangle_at(g, 10, 5, 41 + i, 2 * i + 1, i, C_STAR);
+			}
+			for (k = 0; k < SWIDTH * SHEIGHT; k++) {
+				b += (paints[k] > 1);
+			}
+		}
+		printf("%s rounded rectangles, pixels painted twice: %d\n",
+			(a) ? "Filled" : "Outlined", b);
+	}
 	return 0;
 
 }
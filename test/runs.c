@@ -0,0 +1,195 @@
+/*
+ * Simple Graphics - run slice line test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Draws a fan of lines at every slope, once a pixel at a time and
+ * once with span and column functions, and checks the two agree.
+ * It also counts how many calls each one took. Then every line from
+ * two starting points (one by the corner, so lines get clipped) out
+ * to 20 pixels either way, which covers every octant, single pixels
+ * and pure horizontal and vertical lines, is drawn both ways and
+ * compared with the per-pixel Bresenham loop the library used before.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+
+static uint8_t	pixels[SWIDTH * SHEIGHT];
+static uint8_t	runs[SWIDTH * SHEIGHT];
+static uint8_t	ref[SWIDTH * SHEIGHT];
+static int		pixel_calls, span_calls, column_calls;
+
+void
+count_pixel(void *fb, int x, int y, GFX_COLOR color)
+{
+	pixel_calls++;
+	draw_pixel(fb, x, y, color);
+}
+
+void
+draw_span(void *fb, int x, int y, int len, GFX_COLOR color)
+{
+	span_calls++;
+	memset((uint8_t *) fb + y * SWIDTH + x, color.raw & 0xff, len);
+}
+
+void
+draw_column(void *fb, int x, int y, int len, GFX_COLOR color)
+{
+	column_calls++;
+	while (len-- > 0) {
+		*((uint8_t *) fb + (y++) * SWIDTH + x) = color.raw & 0xff;
+	}
+}
+
+static void
+ref_pixel(int x, int y)
+{
+	if ((x >= 0) && (x < SWIDTH) && (y >= 0) && (y < SHEIGHT)) {
+		ref[y * SWIDTH + x] = '*';
+	}
+}
+
+/* the per-pixel line the run slicing replaced, kept as it was */
+static void
+ref_line(int x0, int y0, int x1, int y1)
+{
+	int mx, my, e;
+	int da = abs(x1 - x0) > abs(y1 - y0);
+
+	if ((x0 == x1) && (y0 == y1)) {
+		ref_pixel(x0, y0);
+		return;
+	}
+	if (x0 == x1) {
+		if (y0 > y1) {
+			e = y0; y0 = y1; y1 = e;
+		}
+		while (y0 <= y1) {
+			ref_pixel(x0, y0);
+			y0++;
+		}
+		return;
+	}
+	if (y0 == y1) {
+		if (x0 > x1) {
+			e = x0; x0 = x1; x1 = e;
+		}
+		while (x0 <= x1) {
+			ref_pixel(x0, y0);
+			x0 ++;
+		}
+		return;
+	}
+	if (da) {
+		if (x1 < x0) {
+			e = x0; x0 = x1; x1 = e;
+			e = y0; y0 = y1; y1 = e;
+		}
+		mx = x1 - x0;
+		my = abs(y1 - y0);
+		e = my - mx;
+		while (x0 <= x1) {
+			ref_pixel(x0, y0);
+			x0++;
+			e += my;
+			if (e > 0) {
+				y0 += (y0 > y1) ? -1 : 1;
+				e -= mx;
+			}
+		}
+	} else {
+		if (y1 < y0) {
+			e = x0; x0 = x1; x1 = e;
+			e = y0; y0 = y1; y1 = e;
+		}
+		my = y1 - y0;
+		mx = abs(x1 - x0);
+		e = mx - my;
+		while (y0 <= y1) {
+			ref_pixel(x0, y0);
+			y0++;
+			e += mx;
+			if (e > 0) {
+				x0 += (x0 > x1) ? -1 : 1;
+				e -= my;
+			}
+		}
+	}
+}
+
+static void
+fan(GFX_CTX *g)
+{
+	int	i;
+
+	for (i = 0; i <= 126; i += 6) {
+		gfx_draw_line_abs(g, 63, 62, i, 1, C_STAR);
+	}
+	for (i = 1; i <= 62; i += 5) {
+		gfx_draw_line_abs(g, 63, 62, 0, i, C_HASH);
+		gfx_draw_line_abs(g, 63, 62, 127, i, C_DOT);
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX	local_context, run_context;
+	GFX_CTX	*g, *rg;
+	const int	start[2][2] = { { 63, 31 }, { 2, 1 } };
+	int		i, s, dx, dy, diffs, lines, bad;
+
+	printf("Lines a pixel at a time and a run at a time\n");
+	g = gfx_init(&local_context, count_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, pixels);
+	memset(pixels, ' ', sizeof(pixels));
+	fan(g);
+	printf("Pixel at a time: %d calls\n", pixel_calls);
+
+	g = gfx_init(&local_context, count_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, screen);
+	gfx_set_span_func(g, draw_span);
+	gfx_set_column_func(g, draw_column);
+	memset(screen, ' ', sizeof(screen));
+	pixel_calls = 0;
+	fan(g);
+	printf("Run at a time: %d span, %d column and %d pixel calls\n",
+		span_calls, column_calls, pixel_calls);
+	for (diffs = 0, i = 0; i < SWIDTH * SHEIGHT; i++) {
+		diffs += (pixels[i] != screen[i]);
+	}
+	printf("Pixels that differ: %d\n", diffs);
+	print_screen();
+
+	g = gfx_init(&local_context, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, pixels);
+	rg = gfx_init(&run_context, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, runs);
+	gfx_set_span_func(rg, draw_span);
+	gfx_set_column_func(rg, draw_column);
+	for (lines = 0, bad = 0, s = 0; s < 2; s++) {
+		for (dy = -20; dy <= 20; dy++) {
+			for (dx = -20; dx <= 20; dx++, lines++) {
+				memset(pixels, ' ', sizeof(pixels));
+				memset(runs, ' ', sizeof(runs));
+				memset(ref, ' ', sizeof(ref));
+				gfx_draw_line_abs(g, start[s][0], start[s][1],
+					start[s][0] + dx, start[s][1] + dy, C_STAR);
+				gfx_draw_line_abs(rg, start[s][0], start[s][1],
+					start[s][0] + dx, start[s][1] + dy, C_STAR);
+				ref_line(start[s][0], start[s][1], start[s][0] + dx, start[s][1] + dy);
+				bad += (memcmp(pixels, ref, sizeof(ref)) != 0) ||
+					   (memcmp(runs, ref, sizeof(ref)) != 0);
+			}
+		}
+	}
+	printf("Lines checked against the per-pixel loop: %d, that differ: %d\n", lines, bad);
+	return (bad != 0);
+}
@@ -0,0 +1,156 @@
+/*
+ * Simple Graphics - scatter plot test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Plots a cloud of points and a small vector field with the batched
+ * point and segment calls, and checks they come out the same as
+ * plotting them one at a time with vp_plot(). Some of the points are
+ * off the view and a couple are NaN. Then it does the same for the
+ * display space calls on a rotated context, and times both ways.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "test.h"
+
+#define POINTS	20000
+#define ARROWS	(9 * 5)
+#define REPEAT	20
+
+static float		xs[POINTS], ys[POINTS];
+static float		field[ARROWS * 4];
+static int			ixy[POINTS * 2];
+static GFX_COLOR	pixels[SWIDTH * SHEIGHT];
+static GFX_COLOR	ref_pixels[SWIDTH * SHEIGHT];
+
+void
+print_bitmap(GFX_COLOR *p)
+{
+	int	x, y;
+
+	for (y = 0; y < SHEIGHT; y++) {
+		for (x = 0; x < SWIDTH; x++) {
+			printf("%c", (char) (p[y * SWIDTH + x].raw & 0xff));
+		}
+		printf("\n");
+	}
+}
+
+int
+differences(void)
+{
+	int	i, n = 0;
+
+	for (i = 0; i < SWIDTH * SHEIGHT; i++) {
+		n += (pixels[i].raw != ref_pixels[i].raw);
+	}
+	return n;
+}
+
+static unsigned
+usec(struct timespec *t0, struct timespec *t1)
+{
+	return (t1->tv_sec - t0->tv_sec) * 1000000 + (t1->tv_nsec - t0->tv_nsec) / 1000;
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX			g, rg;
+	GFX_BITMAP		bm, ref;
+	GFX_VIEW		vp, rvp;
+	struct timespec	t0, t1, t2;
+	uint32_t		seed = 12345;
+	float			r;
+	int				i, j;
+
+	printf("Testing batched points and segments\n");
+	/* two gaussian-ish blobs, some of them past the edges */
+	for (i = 0; i < POINTS; i++) {
+		seed = seed * 1103515245 + 12345;
+		r = ((seed >> 8) & 0xffff) / 65536.0 * 6.2831853;
+		seed = seed * 1103515245 + 12345;
+		xs[i] = ((seed >> 8) & 0xffff) / 65536.0;
+		ys[i] = sin(r) * xs[i] * 1.2;
+		xs[i] = cos(r) * xs[i] * 1.2 + ((i & 1) ? 1.5 : -1.5);
+	}
+	xs[10] = NAN;
+	ys[20] = NAN;
+	/* a swirl */
+	for (i = 0; i < 9; i++) {
+		for (j = 0; j < 5; j++) {
+			float *a = &field[(i * 5 + j) * 4];
+			a[0] = -3.6 + i * 0.9;
+			a[1] = -1.6 + j * 0.8;
+			a[2] = a[0] - a[1] * 0.3;
+			a[3] = a[1] + a[0] * 0.3;
+		}
+	}
+
+	bm.pixels = pixels;
+	bm.stride = SWIDTH;
+	gfx_init_bitmap(&g, &bm, SWIDTH, SHEIGHT, GFX_FONT_LARGE);
+	ref.pixels = ref_pixels;
+	ref.stride = SWIDTH;
+	gfx_init_bitmap(&rg, &ref, SWIDTH, SHEIGHT, GFX_FONT_LARGE);
+	gfx_viewport(&vp, &g, 4, 2, 119, 59, GFX_REAL_INT(-3), GFX_REAL_CONST(-1.5), GFX_REAL_INT(3),
+		GFX_REAL_CONST(1.5));
+	gfx_viewport(&rvp, &rg, 4, 2, 119, 59, GFX_REAL_INT(-3), GFX_REAL_CONST(-1.5), GFX_REAL_INT(3),
+		GFX_REAL_CONST(1.5));
+
+	gfx_fill_screen(&g, C_BLANK);
+	gfx_fill_screen(&rg, C_BLANK);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (j = 0; j < REPEAT; j++) {
+		vp_plot_points(&vp, xs, ys, POINTS, C_DOT);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	for (j = 0; j < REPEAT; j++) {
+		for (i = 0; i < POINTS; i++) {
+			vp_plot(&rvp, xs[i], ys[i], xs[i], ys[i], C_DOT);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	printf("%d points: batched %u usec, one at a time %u usec\n", POINTS * REPEAT,
+		usec(&t0, &t1), usec(&t1, &t2));
+	vp_plot_segments(&vp, field, ARROWS, C_HASH);
+	for (i = 0; i < ARROWS; i++) {
+		vp_plot(&rvp, field[i * 4], field[i * 4 + 1], field[i * 4 + 2],
+			field[i * 4 + 3], C_HASH);
+	}
+	print_bitmap(pixels);
+	printf("vp_plot_points and vp_plot_segments: %d pixels differ from vp_plot\n",
+		differences());
+
+	/* display space on a rotated context, scattered well past the screen */
+	gfx_fill_screen(&g, C_BLANK);
+	gfx_fill_screen(&rg, C_BLANK);
+	gfx_rotate(&g, 30);
+	gfx_rotate(&rg, 30);
+	for (i = 0; i < POINTS; i++) {
+		ixy[2 * i] = isnan(xs[i]) ? 0 : (int) (xs[i] * 30) + SWIDTH / 2;
+		ixy[2 * i + 1] = isnan(ys[i]) ? 0 : (int) (ys[i] * 30) + SHEIGHT / 2;
+	}
+	gfx_draw_points(&g, ixy, POINTS, C_DOT);
+	gfx_draw_segments(&g, ixy, 50, C_STAR);
+	for (i = 0; i < POINTS; i++) {
+		gfx_draw_point_at(&rg, ixy[2 * i], ixy[2 * i + 1], C_DOT);
+	}
+	for (i = 0; i < 50; i++) {
+		gfx_draw_line_abs(&rg, ixy[4 * i], ixy[4 * i + 1], ixy[4 * i + 2],
+			ixy[4 * i + 3], C_STAR);
+	}
+	printf("rotated gfx_draw_points and gfx_draw_segments: %d pixels differ\n",
+		differences());
+	return 0;
+}
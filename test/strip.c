@@ -0,0 +1,116 @@
+/*
+ * Simple Graphics - strip chart test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Runs the same samples through three strip charts. One is on
+ * the usual test screen with a copy function to scroll it, one is
+ * on a GFX_BITMAP (which the library scrolls itself) and the last
+ * is redrawn from scratch for every sample. After every sample
+ * the scrolled charts have to look exactly like the redrawn one.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "test.h"
+
+#define VX	10
+#define VY	6
+#define VW	100
+#define VH	40
+#define STEP	3
+
+static GFX_COLOR	bm_pixels[SWIDTH * SHEIGHT];
+static GFX_COLOR	ref_pixels[SWIDTH * SHEIGHT];
+
+/* scroll part of the test screen */
+void
+copy_screen(void *fb, int x, int y, int w, int h, int dx, int dy)
+{
+	uint8_t *s = fb;
+	int		row;
+
+	if (dy > 0) {
+		for (row = h - 1; row >= 0; row--) {
+			memmove(s + (y + row + dy) * SWIDTH + x + dx, s + (y + row) * SWIDTH + x, w);
+		}
+	} else {
+		for (row = 0; row < h; row++) {
+			memmove(s + (y + row + dy) * SWIDTH + x + dx, s + (y + row) * SWIDTH + x, w);
+		}
+	}
+}
+
+/* count the pixels that are different from the reference chart */
+int
+differences(void)
+{
+	int	i, n = 0;
+
+	for (i = 0; i < SWIDTH * SHEIGHT; i++) {
+		n += (screen[i] != (ref_pixels[i].raw & 0xff));
+		n += (bm_pixels[i].raw != ref_pixels[i].raw);
+	}
+	return n;
+}
+
+void
+setup(GFX_CTX *g, GFX_VIEW *vp)
+{
+	gfx_fill_screen(g, C_DOT);
+	gfx_draw_rectangle_at(g, VX - 1, VY - 1, VW + 2, VH + 3, C_HASH);
+	gfx_viewport(vp, g, VX, VY, VW, VH, GFX_REAL_INT(0), GFX_REAL_CONST(-1.2), GFX_REAL_INT(1),
+		GFX_REAL_CONST(1.2));
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX		g, bg, rg;
+	GFX_BITMAP	bm, ref;
+	GFX_VIEW	vp, bvp, rvp;
+	GFX_STRIP	st, bst, rst;
+	float		y;
+	int			i, bad = 0;
+
+	printf("Testing strip charts\n");
+	gfx_init(&g, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, (void *)screen);
+	gfx_set_copy_func(&g, copy_screen);
+	bm.pixels = bm_pixels;
+	bm.stride = SWIDTH;
+	gfx_init_bitmap(&bg, &bm, SWIDTH, SHEIGHT, GFX_FONT_LARGE);
+	ref.pixels = ref_pixels;
+	ref.stride = SWIDTH;
+	gfx_init_bitmap(&rg, &ref, SWIDTH, SHEIGHT, GFX_FONT_LARGE);
+
+	setup(&g, &vp);
+	setup(&bg, &bvp);
+	setup(&rg, &rvp);
+	vp_strip_init(&st, &vp, STEP, NULL, 0, C_STAR, C_BLANK);
+	vp_strip_init(&bst, &bvp, STEP, NULL, 0, C_STAR, C_BLANK);
+	vp_strip_init(&rst, &rvp, STEP, NULL, 0, C_STAR, C_BLANK);
+
+	for (i = 0; i < 200; i++) {
+		/* a bit past the top and bottom now and then to check clamping */
+		y = 1.4 * sin(i * 0.11) * cos(i * 0.023);
+		vp_strip_add(&st, y);
+		vp_strip_add(&bst, y);
+		rst.ring[rst.head] = y;
+		rst.head = (rst.head + 1) % rst.size;
+		rst.count += (rst.count < rst.size);
+		vp_strip_redraw(&rst);
+		bad += (differences() != 0);
+	}
+	print_screen();
+	printf("%d samples, %d of %d columns per update, %d updates differed from a redraw\n",
+		i, STEP, VW, bad);
+	return 0;
+}
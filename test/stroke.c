@@ -0,0 +1,84 @@
+/*
+ * Simple Graphics - thick line test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Draws wide lines with each kind of end and the same zig-zag with
+ * each kind of corner, then checks that a one pixel wide stroke is
+ * the ordinary polyline and that a diagonal has no gaps.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+
+static uint8_t	thin[SWIDTH * SHEIGHT];
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX	local_context;
+	GFX_CTX	*g;
+	const int	zig[] = { 6, 58, 18, 36, 30, 58, 42, 36 };
+	const int	box[] = { 100, 8, 122, 8, 122, 26, 100, 26, 100, 8 };
+	int		pts[8];
+	int		i, j, last, diffs, gaps;
+
+	g = gfx_init(&local_context, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, screen);
+	printf("Thick lines, butt, square and round ends\n");
+	gfx_fill_screen(g, C_BLANK);
+	for (i = 0; i < 3; i++) {
+		gfx_set_line_style(g, i, GFX_JOIN_MITER);
+		gfx_draw_line_width(g, 8 + i * 30, 5, 24 + i * 30, 5, 5, C_STAR);
+		gfx_draw_line_width(g, 8 + i * 30, 14, 24 + i * 30, 24, 4, C_HASH);
+		gfx_draw_line_width(g, 8 + i * 30, 22, 8 + i * 30, 22, 6, C_PLUS);
+	}
+	gfx_set_line_style(g, GFX_CAP_BUTT, GFX_JOIN_MITER);
+	gfx_draw_polyline_width(g, box, 5, 3, C_AT);
+	printf("Corners, miter, bevel and round\n");
+	for (i = 0; i < 3; i++) {
+		gfx_set_line_style(g, GFX_CAP_BUTT, i);
+		for (j = 0; j < 8; j++) {
+			pts[j] = zig[j] + ((j & 1) ? 0 : i * 42);
+		}
+		gfx_draw_polyline_width(g, pts, 4, 5, C_DOT);
+	}
+	print_screen();
+
+	/* one pixel wide is just the polyline */
+	gfx_fill_screen(g, C_BLANK);
+	gfx_draw_polyline(g, zig, 4, C_STAR);
+	memcpy(thin, screen, sizeof(screen));
+	gfx_fill_screen(g, C_BLANK);
+	gfx_draw_polyline_width(g, zig, 4, 1, C_STAR);
+	diffs = 0;
+	for (i = 0; i < SWIDTH * SHEIGHT; i++) {
+		diffs += (thin[i] != screen[i]);
+	}
+	printf("Width 1 compared to gfx_draw_polyline: %d differences\n", diffs);
+
+	/* every row of a wide diagonal is one run */
+	gfx_fill_screen(g, C_BLANK);
+	gfx_draw_line_width(g, 10, 10, 117, 50, 3, C_STAR);
+	gaps = 0;
+	for (i = 0; i < SHEIGHT; i++) {
+		last = -1;
+		for (j = 0; j < SWIDTH; j++) {
+			if (screen[i * SWIDTH + j] != ' ') {
+				if ((last >= 0) && (last != j - 1)) {
+					gaps++;
+				}
+				last = j;
+			}
+		}
+	}
+	printf("Width 3 diagonal: %d gaps\n", gaps);
+	return 0;
+}
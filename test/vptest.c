@@ -18,6 +18,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+
+#define SWIDTH	100
+#define SHEIGHT	100
 #include "test.h"
 
 int
@@ -27,12 +30,14 @@ main(int argc, char *argv[])
 	GFX_VIEW *vp;
 	memset(screen, ' ', sizeof(screen));
 
-	g = gfx_init(NULL, draw_pixel, 100, 100, GFX_FONT_TINY, NULL);
-	vp = gfx_viewport(NULL, g, 25, 25, 50, 50, -1.0, -1.0, 1.0, 1.0);
-	vp_plot(vp, -.25, -.25, .25, .25, C_STAR);
+	g = gfx_init(NULL, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_TINY, screen);
+	vp = gfx_viewport(NULL, g, 25, 25, 50, 50, GFX_REAL_CONST(-1.0), GFX_REAL_CONST(-1.0),
+		GFX_REAL_CONST(1.0), GFX_REAL_CONST(1.0));
+	vp_plot(vp, GFX_REAL_CONST(-.25), GFX_REAL_CONST(-.25), GFX_REAL_CONST(.25),
+		GFX_REAL_CONST(.25), C_STAR);
 	printf("Out of bounds test\n");
-	vp_plot(vp, 0.5, 0, 1.5, 0, C_PLUS);
+	vp_plot(vp, GFX_REAL_CONST(0.5), GFX_REAL_INT(0), GFX_REAL_CONST(1.5), GFX_REAL_INT(0), C_PLUS);
 	printf("Axis flipped test\n");
-	vp_plot(vp, 0, 0, 0, 1., C_ONE);
+	vp_plot(vp, GFX_REAL_INT(0), GFX_REAL_INT(0), GFX_REAL_INT(0), GFX_REAL_CONST(1.), C_ONE);
 	print_screen();
 }
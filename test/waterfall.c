@@ -0,0 +1,109 @@
+/*
+ * Simple Graphics - waterfall test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Feeds a waterfall spectra with a tone drifting across the band
+ * over a noise floor. The bitmap context scrolls, and the result is
+ * checked against painting every line's colors from scratch. The
+ * plain pixel context can't move pixels so it sweeps instead.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "test.h"
+
+#define LINES	40
+#define BINS	512
+
+static GFX_COLOR	pixels[SWIDTH * SHEIGHT];
+static float		spectra[LINES][BINS];
+static const char	shades[] = " .:-=+*#%@";
+
+void
+print_bitmap(GFX_COLOR *p)
+{
+	int	x, y;
+
+	for (y = 0; y < SHEIGHT; y++) {
+		for (x = 0; x < SWIDTH; x++) {
+			printf("%c", (char) (p[y * SWIDTH + x].raw & 0xff));
+		}
+		printf("\n");
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX			g, sg;
+	GFX_BITMAP		bm;
+	GFX_VIEW		vp, svp;
+	GFX_WATERFALL	wf, swf;
+	GFX_COLOR		lut[sizeof(shades) - 1], row[BINS];
+	uint32_t		seed = 7;
+	float			f, tone;
+	int				i, b, x, y, line, diff = 0;
+
+	printf("Testing waterfall display\n");
+	for (i = 0; i < LINES; i++) {
+		tone = 60 + i * 9;
+		for (b = 0; b < BINS; b++) {
+			seed = seed * 1103515245 + 12345;
+			f = -80 + ((seed >> 16) & 0xff) / 16.0;
+			/* the tone, and a fixed spur that is only one bin wide */
+			f += 70 * exp(-(b - tone) * (b - tone) / 200.0);
+			spectra[i][b] = (b == 400) ? -10 : f;
+		}
+	}
+	for (i = 0; i < (int) sizeof(lut) / (int) sizeof(lut[0]); i++) {
+		lut[i].raw = shades[i];
+	}
+
+	bm.pixels = pixels;
+	bm.stride = SWIDTH;
+	gfx_init_bitmap(&g, &bm, SWIDTH, SHEIGHT, GFX_FONT_LARGE);
+	gfx_fill_screen(&g, C_DOT);
+	gfx_viewport(&vp, &g, 4, 2, 119, 29, GFX_REAL_INT(0), GFX_REAL_INT(0), GFX_REAL_INT(1),
+		GFX_REAL_INT(1));
+	vp_waterfall_init(&wf, &vp, NULL, lut, sizeof(lut) / sizeof(lut[0]), -80, 0, 0);
+	for (i = 0; i < LINES; i++) {
+		vp_waterfall_add(&wf, spectra[i], BINS);
+	}
+	print_bitmap(pixels);
+	/* the top line is the newest spectrum, each row down is one older */
+	for (y = 0; y <= vp.h; y++) {
+		line = LINES - 1 - y;
+		for (x = 0; x <= vp.w; x++) {
+			int b0 = x * BINS / (vp.w + 1), b1 = (x + 1) * BINS / (vp.w + 1);
+			for (f = spectra[line][b0++]; b0 < b1; b0++) {
+				f = (spectra[line][b0] > f) ? spectra[line][b0] : f;
+			}
+			gfx_colormap_map(lut, sizeof(lut) / sizeof(lut[0]), -80, 0, &f, 1, row);
+			diff += (pixels[(vp.y + y) * SWIDTH + vp.x + x].raw != row[0].raw);
+		}
+	}
+	printf("%u lines scrolled, %d pixels differ from drawing them all\n",
+		wf.lines, diff);
+
+	memset(screen, '.', sizeof(screen));
+	gfx_init(&sg, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, screen);
+	gfx_viewport(&svp, &sg, 4, 2, 119, 29, GFX_REAL_INT(0), GFX_REAL_INT(0), GFX_REAL_INT(1),
+		GFX_REAL_INT(1));
+	vp_waterfall_init(&swf, &svp, NULL, lut, sizeof(lut) / sizeof(lut[0]), -80, 0, 0);
+	for (i = 0; i < LINES; i++) {
+		vp_waterfall_add(&swf, spectra[i], BINS);
+	}
+	print_screen();
+	printf("pixel context %s, next line goes on row %d\n",
+		(swf.flags & VP_WATERFALL_SWEEP) ? "sweeps" : "scrolls", swf.head);
+	return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * Simple Graphics - transform and state stack test
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * Draws a dial with its ticks and needle each drawn about [0, 0]
+ * and moved into place with the transform, saving and restoring the
+ * state around each one. It checks that a move or a turn built up
+ * with the transform calls paints the same pixels as drawing it
+ * there directly (or with gfx_rotate), and that the stack puts
+ * everything back and refuses to go too deep.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+
+static uint8_t	pixels[SWIDTH * SHEIGHT];
+
+/* pixels that differ between the screen and the other buffer */
+static int
+differ(void)
+{
+	int	i, n;
+
+	for (n = 0, i = 0; i < SWIDTH * SHEIGHT; i++) {
+		n += (pixels[i] != screen[i]);
+	}
+	return n;
+}
+
+static void
+shape(GFX_CTX *g, int x, int y)
+{
+	gfx_draw_rectangle_at(g, x, y, 20, 9, C_HASH);
+	gfx_draw_line_abs(g, x, y, x + 19, y + 8, C_STAR);
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX	local_context;
+	GFX_CTX	*g;
+	GFX_CTX	before;
+	int		i, ok;
+
+	printf("Transforms and the state stack\n");
+
+	/* moved with gfx_translate or drawn there */
+	g = gfx_init(&local_context, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, pixels);
+	memset(pixels, ' ', sizeof(pixels));
+	shape(g, 40, 20);
+	g = gfx_init(&local_context, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, screen);
+	memset(screen, ' ', sizeof(screen));
+	gfx_translate(g, 30, 15);
+	shape(g, 10, 5);
+	printf("Translated vs drawn in place, pixels that differ: %d\n", differ());
+
+	/* turned about [0, 0] after a move, or by gfx_rotate about the origin */
+	g = gfx_init(&local_context, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, pixels);
+	memset(pixels, ' ', sizeof(pixels));
+	gfx_set_rotation_origin(g, 64, 32);
+	gfx_rotate(g, 90);
+	shape(g, 64, 32);
+	g = gfx_init(&local_context, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, screen);
+	memset(screen, ' ', sizeof(screen));
+	gfx_translate(g, 64, 32);
+	gfx_rotate_by(g, 90);
+	shape(g, 0, 0);
+	printf("Turned 90 vs gfx_rotate(90), pixels that differ: %d\n", differ());
+
+	/* push, change everything, pop */
+	g = gfx_init(&local_context, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, screen);
+	gfx_set_clip(g, 2, 2, 120, 60);
+	before = *g;
+	gfx_push_state(g);
+	gfx_translate(g, 7, 3);
+	gfx_scale(g, 0.5f, 2.0f);
+	gfx_shear(g, -0.25f, 0);
+	gfx_set_text_rotation(g, -90);
+	gfx_set_text_color(g, C_STAR, C_DOT);
+	gfx_clear(g, GFX_CLIP);
+	gfx_pop_state(g);
+	ok = (memcmp(&before.cr, &g->cr, sizeof(g->cr)) == 0) &&
+		 (memcmp(&before.text.cr, &g->text.cr, sizeof(g->text.cr)) == 0) &&
+		 (memcmp(&before.clip, &g->clip, sizeof(g->clip)) == 0) &&
+		 (before.flags == g->flags) &&
+		 (before.text.fg.raw == g->text.fg.raw) && (before.text.bg.raw == g->text.bg.raw);
+	printf("State restored by pop: %s\n", (ok) ? "yes" : "no");
+	for (i = 0; gfx_push_state(g) == 0; i++) ;
+	printf("Pushes before the stack was full: %d\n", i);
+	for (i = 0; gfx_pop_state(g) == 0; i++) ;
+	printf("Pops before it was empty: %d\n", i);
+
+	/* a dial, each tick is the same line turned a bit more */
+	g = gfx_init(&local_context, draw_pixel, SWIDTH, SHEIGHT, GFX_FONT_LARGE, screen);
+	memset(screen, ' ', sizeof(screen));
+	gfx_draw_circle_at(g, 63, 31, 29, C_DOT);
+	for (i = 0; i <= 270; i += 30) {
+		gfx_push_state(g);
+		gfx_translate(g, 63, 31);
+		gfx_rotate_by(g, 225 - i);
+		gfx_draw_line_abs(g, 23, 0, 27, 0, C_HASH);
+		gfx_pop_state(g);
+	}
+	gfx_push_state(g);
+	gfx_translate(g, 63, 31);
+	gfx_rotate_by(g, 100);
+	gfx_draw_line_abs(g, -4, 0, 21, 0, C_STAR);
+	gfx_pop_state(g);
+	print_screen();
+	return 0;
+}
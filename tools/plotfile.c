@@ -0,0 +1,219 @@
+/*
+ * plotfile.c -- Render a binary sample capture to an image
+ *
+ * Copyright (c) 2014-2017 Charles McManis, all rights reserved.
+ *
+ * This source code is licensed under a Creative Commons 4.0
+ * International Public license.
+ *
+ * See: http://creativecommons.org/licenses/by/4.0/legalcode for
+ * details.
+ *
+ * A host tool (it needs mmap and stdio) that plots one channel of
+ * a raw capture file into a viewport and writes the result out as
+ * a PPM. The file is memory mapped and handed to vp_plot_samples()
+ * as is, or with -s it is read through a fixed size window and fed
+ * to the viewport one window at a time. Either way memory use
+ * doesn't depend on the size of the file.
+ *
+ * usage: plotfile [-t type] [-c channels] [-n channel] [-r min,max]
+ *                 [-g wxh] [-s] [-f] capture.raw out.ppm
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <gfx.h>
+
+#define WINDOW	65536		/* bytes per read with -s */
+
+static const struct {
+	char			*name;
+	GFX_SAMPLE_TYPE	type;
+	int				size;
+	float			min, max;	/* default Y range */
+} types[] = {
+	{ "f32", GFX_SAMPLE_F32, 4, -1.0, 1.0 },
+	{ "i16", GFX_SAMPLE_I16, 2, -32768.0, 32767.0 },
+	{ "u16", GFX_SAMPLE_U16, 2, 0, 65535.0 },
+	{ "i8", GFX_SAMPLE_I8, 1, -128.0, 127.0 },
+	{ "u8", GFX_SAMPLE_U8, 1, 0, 255.0 },
+	{ "i32", GFX_SAMPLE_I32, 4, -2147483648.0, 2147483647.0 },
+	{ NULL, 0, 0, 0, 0 }
+};
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: plotfile [-t f32|i16|u16|i8|u8|i32] [-c channels] "
+		"[-n channel]\n\t\t[-r min,max] [-g WxH] [-s] [-f] capture.raw out.ppm\n");
+	fprintf(stderr, "\t-s read the file in %d byte windows instead of mapping it\n",
+		WINDOW);
+	fprintf(stderr, "\t-f plot every segment (no column decimation)\n");
+	exit(1);
+}
+
+static int
+write_ppm(char *name, GFX_BITMAP *bm, int w, int h)
+{
+	FILE		*f;
+	GFX_COLOR	p;
+	int			x, y;
+
+	f = fopen(name, "wb");
+	if (f == NULL) {
+		return -1;
+	}
+	fprintf(f, "P6\n%d %d\n255\n", w, h);
+	for (y = 0; y < h; y++) {
+		for (x = 0; x < w; x++) {
+			p = bm->pixels[y * bm->stride + x];
+			fputc(p.c.r, f);
+			fputc(p.c.g, f);
+			fputc(p.c.b, f);
+		}
+	}
+	return fclose(f);
+}
+
+int
+main(int argc, char *argv[])
+{
+	GFX_CTX		g;
+	GFX_VIEW	vp;
+	GFX_BITMAP	bm;
+	GFX_SAMPLES	d;
+	GFX_SERIES	s;
+	struct stat	st;
+	uint8_t		*map, *win;
+	long		frames, first;
+	ssize_t		got;
+	size_t		size, have;
+	long		n;
+	float		ymin, ymax;
+	int			opt, fd, t = 0, w = 800, h = 300, stream = 0, decimate = 1;
+	int			frame, ranged = 0;
+
+	memset(&d, 0, sizeof(d));
+	d.channels = 1;
+	while ((opt = getopt(argc, argv, "t:c:n:r:g:sf")) != -1) {
+		switch (opt) {
+			case 't':
+				for (t = 0; types[t].name && strcmp(types[t].name, optarg); t++) ;
+				if (types[t].name == NULL) {
+					usage();
+				}
+				break;
+			case 'c':
+				d.channels = atoi(optarg);
+				break;
+			case 'n':
+				d.channel = atoi(optarg);
+				break;
+			case 'r':
+				if (sscanf(optarg, "%f,%f", &ymin, &ymax) != 2) {
+					usage();
+				}
+				ranged = 1;
+				break;
+			case 'g':
+				if ((sscanf(optarg, "%dx%d", &w, &h) != 2) || (w < 8) || (h < 8)) {
+					usage();
+				}
+				break;
+			case 's':
+				stream = 1;
+				break;
+			case 'f':
+				decimate = 0;
+				break;
+			default:
+				usage();
+		}
+	}
+	if ((argc - optind) != 2 || (d.channels < 1) || (d.channel < 0) ||
+		(d.channel >= d.channels)) {
+		usage();
+	}
+	if (! ranged) {
+		ymin = types[t].min;
+		ymax = types[t].max;
+	}
+	d.type = types[t].type;
+	d.scale = 1.0;
+	d.dx = 1.0;
+	frame = types[t].size * d.channels;
+
+	fd = open(argv[optind], O_RDONLY);
+	if ((fd < 0) || (fstat(fd, &st) < 0)) {
+		perror(argv[optind]);
+		exit(1);
+	}
+	frames = st.st_size / frame;
+	if (frames < 2) {
+		fprintf(stderr, "%s: not enough samples to plot\n", argv[optind]);
+		exit(1);
+	}
+
+	bm.stride = w;
+	bm.pixels = calloc(w * h, sizeof(GFX_COLOR));
+	if (bm.pixels == NULL) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	gfx_init_bitmap(&g, &bm, w, h, GFX_FONT_SMALL);
+	gfx_fill_screen(&g, GFX_COLOR_BLACK);
+	gfx_viewport(&vp, &g, 0, 0, w - 1, h - 1, 0, ymin, frames - 1, ymax);
+	vp_set_decimate(&vp, decimate);
+
+	if (! stream) {
+		map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map == MAP_FAILED) {
+			perror("mmap");
+			exit(1);
+		}
+		vp_plot_samples(&vp, &d, map, frames, GFX_COLOR_GREEN);
+		munmap(map, st.st_size);
+	} else {
+		/*
+		 * The window holds at least one frame and is a whole number
+		 * of them. A read can still come back short in the middle of
+		 * a frame, whatever is left over is moved to the front and
+		 * finished off by the next read.
+		 */
+		size = ((WINDOW / frame) > 0) ? (WINDOW / frame) * frame : frame;
+		win = malloc(size);
+		if (win == NULL) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+		vp_series_begin(&s, &vp, GFX_COLOR_GREEN);
+		first = 0;
+		have = 0;
+		while ((first < frames) && ((got = read(fd, win + have, size - have)) > 0)) {
+			have += got;
+			n = have / frame;
+			if (n > 0) {
+				vp_series_samples(&s, &d, win, first, n);
+				first += n;
+				have -= n * frame;
+				memmove(win, win + n * frame, have);
+			}
+		}
+		vp_series_end(&s);
+		free(win);
+	}
+	close(fd);
+
+	if (write_ppm(argv[optind + 1], &bm, w, h) != 0) {
+		perror(argv[optind + 1]);
+		exit(1);
+	}
+	printf("%ld samples plotted into %dx%d %s\n", frames, w, h, argv[optind + 1]);
+	return 0;
+}